@@ -28,21 +28,19 @@
 
 #include "string_view.h"
 #include "traits_adaptors.h"
+#include "__itoa.h"
+#include "__dtoa.h"
 
 #include <stdexcept>
+#include <iterator>
+#include <utility>
 #include <cassert>
 
 namespace stdex {
 
 namespace detail {
 
-template <typename CharT, typename Traits, typename Allocator, typename Tuple>
-inline
-void vsformat(std::basic_string<CharT, Traits, Allocator>&,
-    basic_string_view<CharT>, Tuple);
-
-template <int, int, int, typename>
-struct write_arg_at_impl;
+struct writer_access;
 
 #define _STDEX_G(T, literal) _Generic(T{}, \
     char: literal, \
@@ -52,30 +50,184 @@ struct write_arg_at_impl;
 
 }
 
-template <typename StringType>
+namespace detail {
+
+template <typename Sink, typename = void>
+struct sink_traits_type
+{
+	using type = std::char_traits<typename Sink::value_type>;
+};
+
+template <typename Sink>
+struct sink_traits_type<Sink, void_t<typename Sink::traits_type>>
+{
+	using type = typename Sink::traits_type;
+};
+
+}
+
+// A sink is where a format_writer puts the characters.  sink_traits<S>
+// adapts S to
+//
+//   char_type, traits_type, size_type
+//   size(s)               the number of characters in s
+//   push_back(s, ch)      appends ch
+//   append(s, n, ch)      appends n copies of ch
+//   append(s, p, n)       appends the n characters from p
+//   insert(s, pos, n, ch) inserts n copies of ch before the pos-th one
+//   extend(s, n)          appends n unspecified characters and returns
+//                         a pointer to them, to be overwritten
+//
+// The primary template serves std::basic_string, std::vector and other
+// types with the members used above; where s.append() or s.insert(pos,
+// ...) are missing, it falls back to s.insert(iterator, ...).  Without
+// s.extend(), the characters of s must be contiguous (is_contiguous_sink
+// below), as the fallback hands out a pointer into s.  Specialize it for
+// other buffers.
+namespace detail {
+
+template <typename Sink, typename = void>
+struct is_contiguous_sink_impl : std::false_type {};
+
+template <typename Sink>
+struct is_contiguous_sink_impl<Sink,
+    void_t<decltype(std::declval<Sink&>().data()), typename Sink::iterator>>
+	: std::is_base_of
+	  <
+	      std::random_access_iterator_tag,
+	      typename std::iterator_traits
+	      <
+		  typename Sink::iterator
+	      >::iterator_category
+	  > {};
+
+}
+
+// whether the characters of a sink are stored contiguously, as far as
+// can be told: std::basic_string, std::vector and any type with data()
+// and random-access iterators
+template <typename Sink>
+struct is_contiguous_sink : detail::is_contiguous_sink_impl<Sink> {};
+
+template <typename Sink>
+struct sink_traits
+{
+	using char_type = typename Sink::value_type;
+	using traits_type = typename detail::sink_traits_type<Sink>::type;
+	using size_type = typename Sink::size_type;
+
+	static size_type size(Sink const& s)
+	{
+		return s.size();
+	}
+
+	static void push_back(Sink& s, char_type ch)
+	{
+		s.push_back(ch);
+	}
+
+	static void append(Sink& s, size_type n, char_type ch)
+	{
+		append_n(s, n, ch, 0);
+	}
+
+	static void append(Sink& s, char_type const* p, size_type n)
+	{
+		append_s(s, p, n, 0);
+	}
+
+	static void insert(Sink& s, size_type pos, size_type n, char_type ch)
+	{
+		insert_n(s, pos, n, ch, 0);
+	}
+
+	static char_type* extend(Sink& s, size_type n)
+	{
+		return extend_n(s, n, 0);
+	}
+
+private:
+	template <typename S>
+	static auto append_n(S& s, size_type n, char_type ch, int)
+		-> decltype(void(s.append(n, ch)))
+	{
+		s.append(n, ch);
+	}
+
+	template <typename S>
+	static void append_n(S& s, size_type n, char_type ch, long)
+	{
+		s.insert(s.end(), n, ch);
+	}
+
+	template <typename S>
+	static auto append_s(S& s, char_type const* p, size_type n, int)
+		-> decltype(void(s.append(p, n)))
+	{
+		s.append(p, n);
+	}
+
+	template <typename S>
+	static void append_s(S& s, char_type const* p, size_type n, long)
+	{
+		s.insert(s.end(), p, p + n);
+	}
+
+	template <typename S>
+	static auto insert_n(S& s, size_type pos, size_type n, char_type ch,
+	    int) -> decltype(void(s.insert(pos, n, ch)))
+	{
+		s.insert(pos, n, ch);
+	}
+
+	template <typename S>
+	static void insert_n(S& s, size_type pos, size_type n, char_type ch,
+	    long)
+	{
+		s.insert(s.begin() + pos, n, ch);
+	}
+
+	template <typename S>
+	static auto extend_n(S& s, size_type n, int)
+		-> decltype(s.extend(n))
+	{
+		return s.extend(n);
+	}
+
+	template <typename S>
+	static char_type* extend_n(S& s, size_type n, long)
+	{
+		static_assert(is_contiguous_sink<S>::value,
+		    "a sink without extend() must be contiguous");
+
+		auto sz = s.size();
+		append(s, n, char_type());
+
+		return &s[sz];
+	}
+};
+
+template <typename Sink>
 struct format_writer
 {
-	using char_type = typename StringType::value_type;
-	using traits_type = typename StringType::traits_type;
-	using size_type = typename StringType::size_type;
+	using sink_type = Sink;
+	using char_type = typename sink_traits<Sink>::char_type;
+	using traits_type = typename sink_traits<Sink>::traits_type;
+	using size_type = typename sink_traits<Sink>::size_type;
 
 #ifndef _STDEX_TESTING
 
 private:
-	template <typename CharT, typename Traits, typename Allocator,
-	          typename Tuple>
-	friend
-	void detail::vsformat(std::basic_string<CharT, Traits, Allocator>&,
-	    basic_string_view<CharT>, Tuple);
+	friend struct detail::writer_access;
 
 #endif
 
-	format_writer(StringType& buf) noexcept :
+	format_writer(Sink& buf) noexcept :
 		format_writer(buf, 0)
 	{}
 
-	format_writer(StringType& buf, int width, bool padding_left = false) :
-		buf_(buf), old_sz_(buf_.size()),
+	format_writer(Sink& buf, int width, bool padding_left = false) :
+		buf_(buf), old_sz_(sink::size(buf_)),
 		width_(width), padding_left_(padding_left)
 	{
 		assert(width_ >= 0);
@@ -86,49 +238,55 @@ public:
 	auto send(CharT ch)
 		-> If_t<std::is_same<CharT, char_type>>
 	{
-		buf_.push_back(ch);
+		sink::push_back(buf_, ch);
 	}
 
 	template <typename CharT>
 	auto send(size_type n, CharT ch)
 		-> If_t<std::is_same<CharT, char_type>>
 	{
-		buf_.append(n, ch);
+		sink::append(buf_, n, ch);
 	}
 
 	void send(basic_string_view<char_type, traits_type> s)
 	{
-		buf_.append(s.data(), s.size());
+		sink::append(buf_, s.data(), s.size());
+	}
+
+	// appends n unspecified characters and returns a pointer to the
+	// first of them; the formatter must overwrite all of them.
+	char_type* extend(size_type n)
+	{
+		return sink::extend(buf_, n);
 	}
 
 #define _G(c) _STDEX_G(char_type, c)
 
 	void content_width_will_be(int w)
 	{
-		assert(old_sz_ == buf_.size());
+		assert(old_sz_ == sink::size(buf_));
 
 		if (padding_left_ and w < width_)
-			buf_.append(width_ - w, _G(' '));
+			sink::append(buf_, width_ - w, _G(' '));
 	}
 
 #ifndef _STDEX_TESTING
 
 private:
-	template <int, int, int, typename>
-	friend
-	struct detail::write_arg_at_impl;
+	friend struct detail::writer_access;
 
 #endif
 	void justify_content()
 	{
-		auto w = buf_.size() - old_sz_;
+		auto w = sink::size(buf_) - old_sz_;
 
 		if (w < width_)
 		{
 			if (padding_left_)
-				buf_.insert(old_sz_, width_ - w, _G(' '));
+				sink::insert(buf_, old_sz_, width_ - w,
+				    _G(' '));
 			else
-				buf_.append(width_ - w, _G(' '));
+				sink::append(buf_, width_ - w, _G(' '));
 		}
 	}
 
@@ -140,20 +298,98 @@ private:
 #undef _G
 
 private:
-	StringType&	buf_;
+	using sink = sink_traits<Sink>;
+
+	Sink&		buf_;
 	size_type	old_sz_;
 	int		width_;
 	bool 		padding_left_;
 };
 
+namespace detail {
+
+// the private interface of the writers, for the format drivers
+struct writer_access
+{
+	template <typename Sink>
+	static
+	format_writer<Sink> make(Sink& buf, int width = 0)
+	{
+		return { buf, width };
+	}
+
+	template <typename Writer>
+	static
+	void padding_left(Writer& w)
+	{
+		w.padding_left();
+	}
+
+	template <typename Writer>
+	static
+	void justify_content(Writer& w)
+	{
+		w.justify_content();
+	}
+
+	// whether w has a width to fill with padding on the left
+	template <typename Writer>
+	static
+	bool pads_left(Writer const& w)
+	{
+		return w.padding_left_ and w.width_ > 0;
+	}
+};
+
+}
+
 #define _G(c) _STDEX_G(CharT, c)
 
+// A multi-precision integer as a sign and a magnitude in 64-bit limbs,
+// least significant first; the limbs are not copied.
+struct bigint_view
+{
+	constexpr bigint_view(std::uint64_t const* limbs, std::size_t n,
+	    bool negative = false) noexcept :
+		limbs_(limbs), size_(n), negative_(negative)
+	{}
+
+	constexpr std::uint64_t const* limbs() const noexcept
+	{
+		return limbs_;
+	}
+
+	constexpr std::size_t size() const noexcept
+	{
+		return size_;
+	}
+
+	constexpr bool negative() const noexcept
+	{
+		return negative_;
+	}
+
+private:
+	std::uint64_t const*	limbs_;
+	std::size_t		size_;
+	bool			negative_;
+};
+
+// A formatter may declare the member typedefs
+//
+//   default_left_justified  to be left-justified unless told otherwise;
+//   reports_width           if output() calls content_width_will_be()
+//                           before writing anything, which lets right
+//                           justification pad in place instead of
+//                           formatting the output aside first.
 template <typename T>
 struct formatter;
 
 template <>
 struct formatter<bool>
 {
+	typedef void reports_width;
+
 	formatter() = default;
 
 	template <typename CharT>
@@ -178,36 +414,647 @@ struct formatter<bool>
 
 namespace detail {
 
+template <typename Digits, typename CharT>
+inline
+CharT* write_grouped(CharT* p, Digits const& d, int n)
+{
+	int g = (n - 1) % 3 + 1;
+
+	p = d.write(p, 0, g);
+
+	for (; g < n; g += 3)
+	{
+		*p++ = _G(',');
+		p = d.write(p, g, 3);
+	}
+
+	return p;
+}
+
+// [#][,][type], where type is one of "d", "x", "X", "o" and "b"; "#"
+// adds the "0x", "0X", "0o" or "0b" prefix, and "," separates groups of
+// three decimal digits with commas.
+struct int_spec
+{
+	typedef void reports_width;
+
+	int_spec() = default;
+
+	template <typename CharT>
+	explicit int_spec(basic_string_view<CharT> spec)
+	{
+		if (not spec.empty() and spec.front() == _G('#'))
+		{
+			alt_ = true;
+			spec.remove_prefix(1);
+		}
+
+		if (not spec.empty() and spec.front() == _G(','))
+		{
+			group_ = true;
+			spec.remove_prefix(1);
+		}
+
+		if (spec.size() == 1)
+		{
+			switch (spec.front())
+			{
+			case _G('d'):
+				return;
+			case _G('x'):
+			case _G('X'):
+			case _G('o'):
+			case _G('b'):
+				if (group_)
+					break;
+
+				type_ = char(spec.front());
+				return;
+			}
+		}
+		else if (spec.empty() and (alt_ or group_))
+			return;
+
+		throw std::invalid_argument
+		{
+		    R"(integer format specifier should be "[#][,][dxXob]", )"
+		    R"(with "," only for decimal)"
+		};
+	}
+
+protected:
+	template <typename Writer, typename UInt>
+	void output_magnitude(Writer w, bool neg, UInt u)
+	{
+		using CharT = typename Writer::char_type;
+
+		int n;
+
+		switch (type_)
+		{
+		case 'x':
+		case 'X':
+			n = (bit_width(u) + 3) / 4;
+			break;
+		case 'o':
+			n = (bit_width(u) + 2) / 3;
+			break;
+		case 'b':
+			n = bit_width(u);
+			break;
+		default:
+			n = count_digits(u);
+		}
+
+		if (group_)
+		{
+			int len = neg + n + (n - 1) / 3;
+
+			w.content_width_will_be(len);
+
+			auto p = w.extend(len);
+
+			if (neg)
+				*p++ = _G('-');
+
+			write_digits_grouped(p, n, u, _G(','));
+			return;
+		}
+
+		int prefix = alt_ and type_ != 'd' ? 2 : 0;
+
+		w.content_width_will_be(neg + prefix + n);
+
+		auto p = w.extend(neg + prefix + n);
+
+		if (neg)
+			*p++ = _G('-');
+
+		if (prefix)
+		{
+			*p++ = _G('0');
+			*p++ = CharT(type_);
+		}
+
+		switch (type_)
+		{
+		case 'x':
+		case 'X':
+			write_hex(p, n, u, type_ == 'X');
+			break;
+		case 'o':
+			write_octal(p, n, u);
+			break;
+		case 'b':
+			write_binary(p, n, u);
+			break;
+		default:
+			write_digits(p, n, u);
+		}
+	}
+
+	// the digits of the limbs are generated in place, except that the
+	// decimal digits go through base 10^9 chunks
+	template <typename Writer>
+	void output_magnitude(Writer w, bool neg, std::uint64_t const* limbs,
+	    std::size_t n)
+	{
+		using CharT = typename Writer::char_type;
+
+		while (n and limbs[n - 1] == 0)
+			--n;
+
+		if (n == 0)
+			return output_magnitude(w, false, std::uint64_t(0));
+		if (n == 1)
+			return output_magnitude(w, neg, limbs[0]);
+
+		if (type_ == 'd')
+		{
+			auto chunks = limbs_to_chunks(limbs, n);
+			chunk_digits d(chunks.data(), int(chunks.size()));
+			int len = neg + d.size() +
+			    (group_ ? (d.size() - 1) / 3 : 0);
+
+			w.content_width_will_be(len);
+
+			auto p = w.extend(len);
+
+			if (neg)
+				*p++ = _G('-');
+
+			if (group_)
+				write_grouped(p, d, d.size());
+			else
+				d.write(p, 0, d.size());
+
+			return;
+		}
+
+		int k = type_ == 'b' ? 1 : type_ == 'o' ? 3 : 4;
+		int top = bit_width(limbs[n - 1]);
+		int m = int((64 * (n - 1) + top + k - 1) / k);
+		int prefix = alt_ ? 2 : 0;
+
+		w.content_width_will_be(neg + prefix + m);
+
+		auto p = w.extend(neg + prefix + m);
+
+		if (neg)
+			*p++ = _G('-');
+
+		if (prefix)
+		{
+			*p++ = _G('0');
+			*p++ = CharT(type_);
+		}
+
+		switch (type_)
+		{
+		case 'x':
+		case 'X':
+			p = write_hex(p, (top + 3) / 4, limbs[--n],
+			    type_ == 'X');
+
+			while (n)
+				p = write_hex(p, 16, limbs[--n], type_ == 'X');
+			break;
+		case 'b':
+			p = write_binary(p, top, limbs[--n]);
+
+			while (n)
+				p = write_binary(p, 64, limbs[--n]);
+			break;
+		default:
+			// octal digits straddle the limbs
+			for (std::size_t i = m; i--;)
+			{
+				auto j = 3 * i / 64;
+				auto off = 3 * i % 64;
+				auto v = limbs[j] >> off;
+
+				if (off > 61 and j + 1 < n)
+					v |= limbs[j + 1] << (64 - off);
+
+				*p++ = CharT('0' + (v & 7));
+			}
+		}
+	}
+
+private:
+	char type_ = 'd';
+	bool alt_ = false;
+	bool group_ = false;
+};
+
 template <typename IntType>
-struct int_formatter
+struct int_formatter : int_spec
 {
+	using int_spec::int_spec;
+
 	template <typename Writer>
 	void output(Writer w, IntType v)
 	{
+		using uint_type = digits_uint_t<IntType>;
+
+		bool neg = v < 0;
+
+		output_magnitude(w, neg,
+		    neg ? uint_type(0) - uint_type(v) : uint_type(v));
 	}
 };
 
 template <typename UIntType>
-struct uint_formatter
+struct uint_formatter : int_spec
 {
+	using int_spec::int_spec;
+
 	template <typename Writer>
 	void output(Writer w, UIntType v)
 	{
+		output_magnitude(w, false, digits_uint_t<UIntType>(v));
+	}
+};
+
+template <typename CharT>
+inline
+CharT* copy_digits(CharT* p, char const* first, int n)
+{
+	return std::copy_n(first, n, p);
+}
+
+template <typename CharT>
+inline
+CharT* fill_zeros(CharT* p, int n)
+{
+	return std::fill_n(p, n, _G('0'));
+}
+
+// Sends a field through a small array on the stack, for one too long
+// to extend() at once: a sink with no room of its own would have to
+// allocate for it.
+template <typename Writer>
+struct piecewise_sender
+{
+	using CharT = typename Writer::char_type;
+
+	enum { piece = 128 };
+
+	explicit piecewise_sender(Writer& w) :
+		w_(w)
+	{}
+
+	void send(CharT ch)
+	{
+		*room(1) = ch;
+		++used_;
+	}
+
+	void send(long long n, CharT ch)
+	{
+		flush();
+		w_.send(typename Writer::size_type(n), ch);
 	}
+
+	template <typename Digits>
+	void send_digits(Digits const& d, int from, int n)
+	{
+		while (n)
+		{
+			int m = std::min(n, int(piece));
+
+			d.write(room(m), from, m);
+			used_ += m;
+			from += m;
+			n -= m;
+		}
+	}
+
+	template <typename Digits>
+	void send_grouped(Digits const& d, int n)
+	{
+		int g = (n - 1) % 3 + 1;
+
+		send_digits(d, 0, g);
+
+		for (; g < n; g += 3)
+		{
+			auto p = room(4);
+
+			*p = _G(',');
+			d.write(p + 1, g, 3);
+			used_ += 4;
+		}
+	}
+
+	void flush()
+	{
+		using view_type = basic_string_view<CharT,
+		    typename Writer::traits_type>;
+
+		if (used_)
+			w_.send(view_type(buf_, used_));
+
+		used_ = 0;
+	}
+
+private:
+	CharT* room(int n)
+	{
+		if (piece - used_ < n)
+			flush();
+
+		return buf_ + used_;
+	}
+
+	Writer& w_;
+	int used_ = 0;
+	CharT buf_[piece];
 };
 
+template <typename Writer, typename Digits>
+void write_fixed_piecewise(Writer& w, bool neg, Digits const& d, int frac,
+    int zeros, bool group)
+{
+	using CharT = typename Writer::char_type;
+
+	piecewise_sender<Writer> out(w);
+	int n = d.size();
+	int ilen = n > frac ? n - frac : 1;
+
+	if (neg)
+		out.send(_G('-'));
+
+	if (n <= frac)
+		out.send(_G('0'));
+	else if (group)
+		out.send_grouped(d, ilen);
+	else
+		out.send_digits(d, 0, ilen);
+
+	if ((long long)frac + zeros != 0)
+	{
+		out.send(_G('.'));
+
+		if (n > frac)
+			out.send_digits(d, ilen, frac);
+		else
+		{
+			out.send(frac - n, _G('0'));
+			out.send_digits(d, 0, n);
+		}
+
+		out.send(zeros, _G('0'));
+	}
+
+	out.flush();
+}
+
+// the digits of round(|v| * 10^frac), followed by zeros more
+// fractional zeros
+template <typename Writer, typename Digits>
+void write_fixed(Writer w, bool neg, Digits const& d, int frac, int zeros,
+    bool group = false)
+{
+	using CharT = typename Writer::char_type;
+
+	int n = d.size();
+	int ilen = n > frac ? n - frac : 1;
+	long long flen = (long long)frac + zeros;
+	long long len = neg + ilen + (flen > 0) + flen;
+
+	if (group)
+		len += (ilen - 1) / 3;
+
+	// a precision near INT_MAX
+	if (len > std::numeric_limits<int>::max())
+		throw std::overflow_error
+		{
+		    "integer overflow in format"
+		};
+
+	w.content_width_will_be(int(len));
+
+	if (len > piecewise_sender<Writer>::piece)
+		return write_fixed_piecewise(w, neg, d, frac, zeros, group);
+
+	auto p = w.extend(len);
+
+	if (neg)
+		*p++ = _G('-');
+
+	if (n <= frac)
+		*p++ = _G('0');
+	else if (group)
+		p = write_grouped(p, d, ilen);
+	else
+		p = d.write(p, 0, ilen);
+
+	if (flen == 0)
+		return;
+
+	*p++ = _G('.');
+
+	if (n > frac)
+		p = d.write(p, ilen, frac);
+	else
+	{
+		p = fill_zeros(p, frac - n);
+		p = d.write(p, 0, n);
+	}
+
+	fill_zeros(p, zeros);
+}
+
+// Python's repr: positional notation for exponents in [-4, 16),
+// scientific notation otherwise.
+template <typename Writer>
+void write_shortest(Writer w, bool neg, decimal_string& d,
+    bool group = false)
+{
+	using CharT = typename Writer::char_type;
+
+	while (d.size > 1 and d.digits[d.size - 1] == '0')
+		--d.size;
+
+	int exp = d.point - 1;
+	int n = d.size;
+
+	if (-4 <= exp and exp < 16)
+		return write_fixed(w, neg,
+		    string_digits(d.digits, n, std::max(n, d.point)),
+		    std::max(n - d.point, 0), d.point >= n, group);
+
+	unsigned e = exp < 0 ? -exp : exp;
+	int en = std::max(count_digits(e), 2);
+	int len = neg + n + (n > 1) + 2 + en;
+
+	w.content_width_will_be(len);
+
+	auto p = w.extend(len);
+
+	if (neg)
+		*p++ = _G('-');
+
+	*p++ = CharT(d.digits[0]);
+
+	if (n > 1)
+	{
+		*p++ = _G('.');
+		p = copy_digits(p, d.digits + 1, n - 1);
+	}
+
+	*p++ = _G('e');
+	*p++ = exp < 0 ? _G('-') : _G('+');
+
+	if (e < 10)
+		*p++ = _G('0');
+
+	write_digits(p, count_digits(e), e);
+}
+
+template <typename CharT>
+inline
+int parse_precision(basic_string_view<CharT>& s)
+{
+	int n = 0;
+
+	if (s.empty() or s.front() < _G('0') or _G('9') < s.front())
+		throw std::invalid_argument
+		{
+		    "expecting a precision"
+		};
+
+	for (; not s.empty() and _G('0') <= s.front() and
+	    s.front() <= _G('9'); s.remove_prefix(1))
+	{
+		int d = s.front() - _G('0');
+
+		if ((std::numeric_limits<int>::max() - d) / 10 < n)
+			throw std::overflow_error
+			{
+			    "integer overflow in format"
+			};
+
+		n = n * 10 + d;
+	}
+
+	return n;
+}
+
 template <typename RealType>
 struct float_formatter
 {
+	typedef void reports_width;
+
+	float_formatter() = default;
+
+	// fixed notation with precision digits, or the shortest form if
+	// precision is negative
+	explicit float_formatter(int precision) :
+		precision_(precision)
+	{}
+
+	// [,][.precision]f, or "," alone for the shortest representation
+	// with groups of three integral digits separated by commas
+	template <typename CharT>
+	explicit float_formatter(basic_string_view<CharT> spec)
+	{
+		if (not spec.empty() and spec.front() == _G(','))
+		{
+			group_ = true;
+			spec.remove_prefix(1);
+
+			if (spec.empty())
+				return;
+		}
+
+		if (not spec.empty() and spec.front() == _G('.'))
+		{
+			spec.remove_prefix(1);
+			precision_ = parse_precision(spec);
+		}
+		else
+			precision_ = 6;
+
+		if (spec != _G("f"))
+			throw std::invalid_argument
+			{
+			    R"(floating-point format specifier should be )"
+			    R"("[,][.precision]f")"
+			};
+	}
+
 	template <typename Writer>
 	void output(Writer w, RealType v)
 	{
+		using CharT = typename Writer::char_type;
+
+		bool neg = std::signbit(v);
+
+		if (std::isnan(v))
+		{
+			w.content_width_will_be(3);
+			w.send(_G("nan"));
+			return;
+		}
+
+		if (std::isinf(v))
+		{
+			w.content_width_will_be(3 + neg);
+			w.send(neg ? _G("-inf") : _G("inf"));
+			return;
+		}
+
+		if (neg)
+			v = -v;
+
+		if (precision_ >= 0)
+			return output_fixed(w, neg, v);
+
+		decimal_string d;
+
+		if (v == 0)
+		{
+			d.digits[0] = '0';
+			d.size = 1;
+			d.point = 1;
+		}
+		else
+			shortest(v, d);
+
+		write_shortest(w, neg, d, group_);
+	}
+
+private:
+	template <typename Writer>
+	void output_fixed(Writer w, bool neg, RealType v)
+	{
+		auto x = decompose(v);
+		std::uint64_t q;
+
+		if (fixed_fast(x, precision_, q))
+			return write_fixed(w, neg, u64_digits(q), precision_,
+			    0, group_);
+
+		std::uint32_t chunks[fixed_chunks<RealType>()];
+		int frac, zeros;
+		int n = fixed_exact<fixed_limbs<RealType>()>(x, precision_,
+		    chunks, frac, zeros);
+
+		write_fixed(w, neg, chunk_digits(chunks, n), frac, zeros,
+		    group_);
 	}
+
+	int precision_ = -1;
+	bool group_ = false;
 };
 
 template <typename CharT>
 struct char_formatter
 {
+	typedef void reports_width;
+
 	char_formatter() = default;
 
 	explicit char_formatter(basic_string_view<CharT> spec)
@@ -232,6 +1079,7 @@ struct char_formatter
 template <>
 struct formatter<signed char> : detail::int_formatter<signed char>
 {
+	using int_formatter::int_formatter;
 };
 
 template <>
@@ -261,6 +1109,7 @@ struct formatter<long long> : detail::int_formatter<long long>
 template <>
 struct formatter<unsigned char> : detail::uint_formatter<unsigned char>
 {
+	using uint_formatter::uint_formatter;
 };
 
 template <>
@@ -288,6 +1137,35 @@ struct formatter<unsigned long long>
 	using uint_formatter::uint_formatter;
 };
 
+#if defined(__SIZEOF_INT128__)
+
+template <>
+struct formatter<detail::int128_t> : detail::int_formatter<detail::int128_t>
+{
+	using int_formatter::int_formatter;
+};
+
+template <>
+struct formatter<detail::uint128_t>
+	: detail::uint_formatter<detail::uint128_t>
+{
+	using uint_formatter::uint_formatter;
+};
+
+#endif
+
+template <>
+struct formatter<bigint_view> : detail::int_spec
+{
+	using int_spec::int_spec;
+
+	template <typename Writer>
+	void output(Writer w, bigint_view v)
+	{
+		output_magnitude(w, v.negative(), v.limbs(), v.size());
+	}
+};
+
 template <>
 struct formatter<float> : detail::float_formatter<float>
 {
@@ -334,6 +1212,7 @@ template <typename CharT, typename Traits>
 struct formatter<basic_string_view<CharT, Traits>>
 {
 	typedef void default_left_justified;
+	typedef void reports_width;
 
 	formatter() = default;
 
@@ -409,9 +1288,19 @@ struct formatter<char32_t*> : formatter<char32_t const*>
 	using formatter<char32_t const*>::formatter;
 };
 
+namespace detail {
+
+// the base of the formatter below, which tells it from a formatter<T*>
+// specialized for a user type
+struct address_formatter {};
+
+}
+
 template <typename T>
-struct formatter<T*>
+struct formatter<T*> : detail::address_formatter
 {
+	typedef void reports_width;
+
 	formatter() = default;
 
 	template <typename CharT>
@@ -423,8 +1312,33 @@ struct formatter<T*>
 			    R"(pointer format specifier should be "p")"
 			};
 	}
+
+	template <typename Writer>
+	void output(Writer w, T* p)
+	{
+		using CharT = typename Writer::char_type;
+
+		auto u = reinterpret_cast<std::uintptr_t>(p);
+		int n = (detail::bit_width(u) + 3) / 4;
+
+		w.content_width_will_be(n + 2);
+
+		auto s = w.extend(n + 2);
+		s[0] = _G('0');
+		s[1] = _G('x');
+		detail::write_hex(s + 2, n, u);
+	}
 };
 
+namespace detail {
+
+// whether a T* is written as its address by the formatter above
+template <typename T>
+struct formats_address
+	: std::is_base_of<address_formatter, formatter<T*>> {};
+
+}
+
 #undef _G
 
 }
@@ -0,0 +1,224 @@
+/*-
+ * Copyright (c) 2013 Zhihao Yuan.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _STDEX___HASH_H
+#define _STDEX___HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace stdex {
+
+namespace detail {
+
+struct hash_u128
+{
+	std::uint64_t lo;
+	std::uint64_t hi;
+};
+
+constexpr
+hash_u128 hash_mum(std::uint64_t a, std::uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+	__extension__ typedef unsigned __int128 u128;
+
+	return { std::uint64_t(u128(a) * b), std::uint64_t(u128(a) * b >> 64) };
+#else
+	std::uint64_t ha = a >> 32, la = std::uint32_t(a);
+	std::uint64_t hb = b >> 32, lb = std::uint32_t(b);
+	std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	std::uint64_t t = rl + (rm0 << 32);
+	std::uint64_t lo = t + (rm1 << 32);
+
+	return { lo, rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (lo < t) };
+#endif
+}
+
+constexpr
+std::uint64_t hash_fold(std::uint64_t a, std::uint64_t b)
+{
+	auto m = hash_mum(a, b);
+
+	return m.lo ^ m.hi;
+}
+
+constexpr std::uint64_t hash_p0 = 0xa0761d6478bd642fULL;
+constexpr std::uint64_t hash_p1 = 0xe7037ed1a0b428dbULL;
+constexpr std::uint64_t hash_p2 = 0x8ebc6af09c88c6e3ULL;
+constexpr std::uint64_t hash_p3 = 0x589965cc75374cc3ULL;
+
+// The bytes of a character sequence in little-endian order, one
+// shift at a time; usable in constant expressions.
+template <typename CharT>
+struct char_bytes
+{
+	typedef typename std::make_unsigned<CharT>::type unsigned_type;
+
+	constexpr std::uint64_t byte(std::size_t k) const
+	{
+		return std::uint64_t(unsigned_type(s[k / sizeof(CharT)]) >>
+		    (8 * (k % sizeof(CharT)))) & 0xff;
+	}
+
+	constexpr std::uint64_t word(std::size_t k, int n) const
+	{
+		std::uint64_t v = 0;
+
+		for (int j = n; j-- > 0;)
+			v = v << 8 | byte(k + j);
+
+		return v;
+	}
+
+	constexpr std::uint64_t r4(std::size_t k) const
+	{
+		return word(k, 4);
+	}
+
+	constexpr std::uint64_t r8(std::size_t k) const
+	{
+		return word(k, 8);
+	}
+
+	CharT const* s;
+};
+
+// the same bytes with unaligned loads, on little-endian targets
+struct loaded_bytes
+{
+	std::uint64_t byte(std::size_t k) const
+	{
+		return p[k];
+	}
+
+	std::uint64_t r4(std::size_t k) const
+	{
+		std::uint32_t v;
+		std::memcpy(&v, p + k, 4);
+
+		return v;
+	}
+
+	std::uint64_t r8(std::size_t k) const
+	{
+		std::uint64_t v;
+		std::memcpy(&v, p + k, 8);
+
+		return v;
+	}
+
+	unsigned char const* p;
+};
+
+// A wyhash-style hash of n bytes.  Inputs over 48 bytes are folded
+// in three independent lanes, so that their 64 x 64 -> 128-bit
+// multiplies overlap in the pipeline; short inputs take a couple of
+// overlapping loads.
+template <typename Bytes>
+constexpr
+std::uint64_t hash_bytes(Bytes r, std::size_t n)
+{
+	auto seed = hash_fold(hash_p0, hash_p1);
+	std::uint64_t a = 0;
+	std::uint64_t b = 0;
+
+	if (n <= 16)
+	{
+		if (n >= 4)
+		{
+			auto mid = (n >> 3) << 2;
+
+			a = r.r4(0) << 32 | r.r4(mid);
+			b = r.r4(n - 4) << 32 | r.r4(n - 4 - mid);
+		}
+		else if (n > 0)
+			a = r.byte(0) << 16 | r.byte(n >> 1) << 8 |
+			    r.byte(n - 1);
+	}
+	else
+	{
+		std::size_t p = 0;
+		std::size_t i = n;
+
+		if (i > 48)
+		{
+			auto see1 = seed;
+			auto see2 = seed;
+
+			do
+			{
+				seed = hash_fold(r.r8(p) ^ hash_p1,
+				    r.r8(p + 8) ^ seed);
+				see1 = hash_fold(r.r8(p + 16) ^ hash_p2,
+				    r.r8(p + 24) ^ see1);
+				see2 = hash_fold(r.r8(p + 32) ^ hash_p3,
+				    r.r8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+
+			seed ^= see1 ^ see2;
+		}
+
+		for (; i > 16; p += 16, i -= 16)
+			seed = hash_fold(r.r8(p) ^ hash_p1,
+			    r.r8(p + 8) ^ seed);
+
+		a = r.r8(p + i - 16);
+		b = r.r8(p + i - 8);
+	}
+
+	auto m = hash_mum(a ^ hash_p1, b ^ seed);
+
+	return hash_fold(m.lo ^ hash_p0 ^ n, m.hi ^ hash_p1);
+}
+
+// hash_chars(s, n) == hash_chars_constant(s, n) on every target
+template <typename CharT>
+constexpr
+std::uint64_t hash_chars_constant(CharT const* s, std::size_t n)
+{
+	return hash_bytes(char_bytes<CharT>{ s }, n * sizeof(CharT));
+}
+
+template <typename CharT>
+inline
+std::uint64_t hash_chars(CharT const* s, std::size_t n)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	return hash_bytes(loaded_bytes{
+	    reinterpret_cast<unsigned char const*>(s) }, n * sizeof(CharT));
+#else
+	return hash_chars_constant(s, n);
+#endif
+}
+
+}
+}
+
+#endif
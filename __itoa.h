@@ -0,0 +1,657 @@
+/*-
+ * Copyright (c) 2013 Zhihao Yuan.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _STDEX___ITOA_H
+#define _STDEX___ITOA_H
+
+#include "traits_adaptors.h"
+
+#include <type_traits>
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace stdex {
+
+namespace detail {
+
+template <typename = void>
+struct digits_table
+{
+	static constexpr char pairs[] =
+	    "00010203040506070809"
+	    "10111213141516171819"
+	    "20212223242526272829"
+	    "30313233343536373839"
+	    "40414243444546474849"
+	    "50515253545556575859"
+	    "60616263646566676869"
+	    "70717273747576777879"
+	    "80818283848586878889"
+	    "90919293949596979899";
+
+	// 0 instead of 1 so that count_digits(0) == 1
+	static constexpr std::uint64_t powers_of_10[] =
+	{
+	    0,
+	    10ull,
+	    100ull,
+	    1000ull,
+	    10000ull,
+	    100000ull,
+	    1000000ull,
+	    10000000ull,
+	    100000000ull,
+	    1000000000ull,
+	    10000000000ull,
+	    100000000000ull,
+	    1000000000000ull,
+	    10000000000000ull,
+	    100000000000000ull,
+	    1000000000000000ull,
+	    10000000000000000ull,
+	    100000000000000000ull,
+	    1000000000000000000ull,
+	    10000000000000000000ull,
+	};
+};
+
+template <typename T>
+constexpr char digits_table<T>::pairs[];
+
+template <typename T>
+constexpr std::uint64_t digits_table<T>::powers_of_10[];
+
+inline
+int bit_width(std::uint64_t n)
+{
+#if defined(__GNUC__)
+	return 64 - __builtin_clzll(n | 1);
+#else
+	int w = 1;
+
+	while (n >>= 1)
+		++w;
+
+	return w;
+#endif
+}
+
+// log10(2) ~= 1233 / 4096; off by at most one, fixed up by a
+// single comparison.
+inline
+int count_digits(std::uint64_t n)
+{
+	int t = bit_width(n) * 1233 >> 12;
+
+	return t - (n < digits_table<>::powers_of_10[t]) + 1;
+}
+
+inline
+std::uint64_t power_of_10(int n)
+{
+	return n ? digits_table<>::powers_of_10[n] : 1;
+}
+
+template <typename CharT>
+inline
+void copy_2digits(CharT* p, unsigned i)
+{
+	auto d = digits_table<>::pairs + 2 * i;
+
+	p[0] = CharT(d[0]);
+	p[1] = CharT(d[1]);
+}
+
+// fills [p, p + n) with the decimal digits of v, where n is the
+// digits count of v.
+template <typename CharT, typename UInt>
+inline
+CharT* write_digits(CharT* p, int n, UInt v)
+{
+	auto q = p + n;
+
+	while (v >= 100)
+	{
+		auto i = unsigned(v % 100);
+		v /= 100;
+		q -= 2;
+		copy_2digits(q, i);
+	}
+
+	if (v >= 10)
+		copy_2digits(q - 2, unsigned(v));
+	else
+		q[-1] = CharT('0' + v);
+
+	return p + n;
+}
+
+// fills [p, p + n) with v, zero-padded; v < 10^n
+template <typename CharT, typename UInt>
+inline
+CharT* write_digits_padded(CharT* p, int n, UInt v)
+{
+	int m = count_digits(v);
+
+	p = std::fill_n(p, n - m, CharT('0'));
+
+	return write_digits(p, m, v);
+}
+
+#if defined(__SIZEOF_INT128__)
+
+using int128_t = __int128;
+using uint128_t = unsigned __int128;
+
+// the 128-bit overloads must not be candidates for narrower types
+template <typename UInt, typename R>
+using if_uint128_t = If_t<std::is_same<UInt, uint128_t>, identity_of<R>>;
+
+// 10^19, the largest power of 10 in 64 bits
+constexpr std::uint64_t pow10_19 = 10000000000000000000ull;
+
+template <typename UInt>
+inline
+auto bit_width(UInt n) -> if_uint128_t<UInt, int>
+{
+	auto hi = std::uint64_t(n >> 64);
+
+	return hi ? 64 + bit_width(hi) : bit_width(std::uint64_t(n));
+}
+
+template <typename UInt>
+inline
+auto count_digits(UInt n) -> if_uint128_t<UInt, int>
+{
+	if ((n >> 64) == 0)
+		return count_digits(std::uint64_t(n));
+
+	// 19 <= t <= 38
+	int t = bit_width(n) * 1233 >> 12;
+
+	return t - (n < uint128_t(pow10_19) * power_of_10(t - 19)) + 1;
+}
+
+// splits v into 10^19 chunks, so that only one 128-bit division is
+// needed for every 19 digits.
+template <typename CharT>
+inline
+CharT* write_digits(CharT* p, int n, uint128_t v)
+{
+	if (n <= 19)
+		return write_digits(p, n, std::uint64_t(v));
+
+	auto q = v / pow10_19;
+
+	write_digits_padded(p + n - 19, 19, std::uint64_t(v - q * pow10_19));
+	write_digits(p, n - 19, q);
+
+	return p + n;
+}
+
+#endif
+
+// fills [p, p + n + (n - 1) / 3) with the decimal digits of v, where n
+// is the digits count of v, separating groups of three with sep.
+template <typename CharT, typename UInt>
+inline
+CharT* write_digits_grouped(CharT* p, int n, UInt v, CharT sep)
+{
+	auto last = p + n + (n - 1) / 3;
+	auto q = last;
+
+	for (; n > 3; n -= 3)
+	{
+		auto i = unsigned(v % 1000);
+		v /= 1000;
+		q -= 3;
+		write_digits_padded(q, 3, i);
+		*--q = sep;
+	}
+
+	write_digits(p, n, v);
+
+	return last;
+}
+
+#if defined(__SIZEOF_INT128__)
+
+// 10^18 chunks keep the groups aligned
+template <typename CharT>
+inline
+CharT* write_digits_grouped(CharT* p, int n, uint128_t v, CharT sep)
+{
+	if ((v >> 64) == 0)
+		return write_digits_grouped(p, n, std::uint64_t(v), sep);
+
+	auto q = v / power_of_10(18);
+	auto r = std::uint64_t(v - q * power_of_10(18));
+
+	p = write_digits_grouped(p, n - 18, q, sep);
+
+	auto last = p + 24;
+
+	for (auto it = last; it != p; r /= 1000)
+	{
+		it -= 3;
+		write_digits_padded(it, 3, unsigned(r % 1000));
+		*--it = sep;
+	}
+
+	return last;
+}
+
+#endif
+
+inline
+std::uint64_t byte_swap(std::uint64_t x)
+{
+#if defined(__GNUC__)
+	return __builtin_bswap64(x);
+#else
+	x = ((x & 0x00ff00ff00ff00ffull) << 8) |
+	    ((x >> 8) & 0x00ff00ff00ff00ffull);
+	x = ((x & 0x0000ffff0000ffffull) << 16) |
+	    ((x >> 16) & 0x0000ffff0000ffffull);
+
+	return (x << 32) | (x >> 32);
+#endif
+}
+
+// nibble i of v, counting from the most significant, to byte i of the
+// result, counting from the least significant
+inline
+std::uint64_t spread_nibbles(std::uint32_t v)
+{
+	std::uint64_t x = v;
+
+	x = (x | (x << 16)) & 0x0000ffff0000ffffull;
+	x = (x | (x << 8)) & 0x00ff00ff00ff00ffull;
+	x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0full;
+
+	return byte_swap(x);
+}
+
+// 0-15 in each byte to '0'-'9', 'a'-'f' or 'A'-'F'
+inline
+std::uint64_t hex_ascii(std::uint64_t x, bool upper)
+{
+	auto letters = ((x + 0x0606060606060606ull) >> 4) &
+	    0x0101010101010101ull;
+
+	return x + 0x3030303030303030ull + letters * (upper ? 7 : 39);
+}
+
+template <typename CharT>
+inline
+CharT* copy_bytes(CharT* p, std::uint64_t x)
+{
+	for (int i = 0; i < 8; ++i)
+		*p++ = CharT(char(x >> (8 * i)));
+
+	return p;
+}
+
+// the last n hex digits of v
+template <typename CharT>
+inline
+CharT* write_hex(CharT* p, int n, std::uint64_t v, bool upper = false)
+{
+	CharT buf[16];
+
+	copy_bytes(buf, hex_ascii(spread_nibbles(std::uint32_t(v >> 32)),
+	    upper));
+	copy_bytes(buf + 8, hex_ascii(spread_nibbles(std::uint32_t(v)),
+	    upper));
+
+	return std::copy_n(buf + 16 - n, n, p);
+}
+
+// the last n binary digits of v
+template <typename CharT>
+inline
+CharT* write_binary(CharT* p, int n, std::uint64_t v)
+{
+	CharT buf[64];
+
+	for (int i = 0; i < 8; ++i)
+	{
+		// bit 7 - j of the byte to byte j
+		auto x = ((v >> (56 - 8 * i)) & 0xff) * 0x0101010101010101ull &
+		    0x0102040810204080ull;
+		x = ((x + 0x7f7f7f7f7f7f7f7full) >> 7) & 0x0101010101010101ull;
+
+		copy_bytes(buf + 8 * i, x + 0x3030303030303030ull);
+	}
+
+	return std::copy_n(buf + 64 - n, n, p);
+}
+
+// the last n octal digits of v
+template <typename CharT>
+inline
+CharT* write_octal(CharT* p, int n, std::uint64_t v)
+{
+	for (auto q = p + n; q != p; v >>= 3)
+		*--q = CharT('0' + (v & 7));
+
+	return p + n;
+}
+
+#if defined(__SIZEOF_INT128__)
+
+template <typename CharT, typename UInt>
+inline
+auto write_hex(CharT* p, int n, UInt v, bool upper = false)
+	-> if_uint128_t<UInt, CharT*>
+{
+	if (n <= 16)
+		return write_hex(p, n, std::uint64_t(v), upper);
+
+	p = write_hex(p, n - 16, std::uint64_t(v >> 64), upper);
+
+	return write_hex(p, 16, std::uint64_t(v), upper);
+}
+
+template <typename CharT, typename UInt>
+inline
+auto write_binary(CharT* p, int n, UInt v)
+	-> if_uint128_t<UInt, CharT*>
+{
+	if (n <= 64)
+		return write_binary(p, n, std::uint64_t(v));
+
+	p = write_binary(p, n - 64, std::uint64_t(v >> 64));
+
+	return write_binary(p, 64, std::uint64_t(v));
+}
+
+// 21 octal digits per 63 bits
+template <typename CharT, typename UInt>
+inline
+auto write_octal(CharT* p, int n, UInt v)
+	-> if_uint128_t<UInt, CharT*>
+{
+	if (n <= 21)
+		return write_octal(p, n, std::uint64_t(v));
+
+	p = write_octal(p, n - 21, v >> 63);
+
+	return write_octal(p, 21, std::uint64_t(v));
+}
+
+#endif
+
+// widest unsigned type with a fast division for an integral type
+template <typename IntType>
+using digits_uint_t = std::conditional_t
+	<
+	    (sizeof(IntType) <= sizeof(std::uint32_t)),
+	    std::uint32_t,
+#if defined(__SIZEOF_INT128__)
+	    std::conditional_t
+	    <
+		(sizeof(IntType) <= sizeof(std::uint64_t)),
+		std::uint64_t,
+		uint128_t
+	    >
+#else
+	    std::uint64_t
+#endif
+	>;
+
+// Multi-limb radix conversion: magnitudes in 64-bit limbs to base 10^9
+// chunks, both least significant first.
+
+constexpr std::uint32_t chunk_base = 1000000000;
+
+// below these sizes the quadratic algorithms are faster
+constexpr std::size_t karatsuba_threshold = 40;	// in chunks
+constexpr std::size_t radix_dc_threshold = 32;	// in limbs
+
+using chunk_vector = std::vector<std::uint32_t>;
+
+inline
+void trim_chunks(chunk_vector& v)
+{
+	while (not v.empty() and v.back() == 0)
+		v.pop_back();
+}
+
+// r[0, rn) += a[0, an), where an <= rn and the sum fits
+inline
+void chunks_add_to(std::uint32_t* r, std::size_t rn,
+    std::uint32_t const* a, std::size_t an)
+{
+	std::uint32_t carry = 0;
+	std::size_t i = 0;
+
+	for (; i < an; ++i)
+	{
+		auto t = r[i] + a[i] + carry;
+		carry = t >= chunk_base;
+		r[i] = carry ? t - chunk_base : t;
+	}
+
+	for (; carry and i < rn; ++i)
+	{
+		carry = ++r[i] == chunk_base;
+
+		if (carry)
+			r[i] = 0;
+	}
+}
+
+// r[0, rn) -= a[0, an), where an <= rn and the difference is not
+// negative
+inline
+void chunks_sub_from(std::uint32_t* r, std::size_t rn,
+    std::uint32_t const* a, std::size_t an)
+{
+	std::uint32_t borrow = 0;
+	std::size_t i = 0;
+
+	for (; i < an; ++i)
+	{
+		auto d = a[i] + borrow;
+		borrow = r[i] < d;
+		r[i] = r[i] + (borrow ? chunk_base : 0) - d;
+	}
+
+	for (; borrow and i < rn; ++i)
+	{
+		borrow = r[i] == 0;
+		r[i] = borrow ? chunk_base - 1 : r[i] - 1;
+	}
+}
+
+// r[0, n + m) = a[0, n) * b[0, m)
+inline
+void chunks_mul_basecase(std::uint32_t* r, std::uint32_t const* a,
+    std::size_t n, std::uint32_t const* b, std::size_t m)
+{
+	std::fill_n(r, n + m, 0);
+
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		std::uint64_t carry = 0;
+
+		if (a[i] == 0)
+			continue;
+
+		for (std::size_t j = 0; j < m; ++j)
+		{
+			auto t = r[i + j] + std::uint64_t(a[i]) * b[j] + carry;
+			r[i + j] = std::uint32_t(t % chunk_base);
+			carry = t / chunk_base;
+		}
+
+		r[i + m] = std::uint32_t(carry);
+	}
+}
+
+// r[0, n + m) = a[0, n) * b[0, m), Karatsuba
+inline
+void chunks_mul(std::uint32_t* r, std::uint32_t const* a, std::size_t n,
+    std::uint32_t const* b, std::size_t m)
+{
+	if (n < m)
+	{
+		std::swap(a, b);
+		std::swap(n, m);
+	}
+
+	if (m < karatsuba_threshold)
+		return chunks_mul_basecase(r, a, n, b, m);
+
+	auto h = (n + 1) / 2;
+
+	// a0 * b + a1 * b * B^h
+	if (m <= h)
+	{
+		chunk_vector t(n - h + m);
+
+		chunks_mul(r, a, h, b, m);
+		chunks_mul(t.data(), a + h, n - h, b, m);
+		std::fill(r + h + m, r + n + m, 0);
+		chunks_add_to(r + h, n + m - h, t.data(), t.size());
+
+		return;
+	}
+
+	// (a0 + a1)(b0 + b1) - a0 * b0 - a1 * b1 = a0 * b1 + a1 * b0
+	chunk_vector sa(h + 1), sb(h + 1), z1(2 * h + 2);
+
+	std::copy_n(a, h, sa.begin());
+	chunks_add_to(sa.data(), h + 1, a + h, n - h);
+	std::copy_n(b, h, sb.begin());
+	chunks_add_to(sb.data(), h + 1, b + h, m - h);
+
+	chunks_mul(r, a, h, b, h);
+	chunks_mul(r + 2 * h, a + h, n - h, b + h, m - h);
+	chunks_mul(z1.data(), sa.data(), h + 1, sb.data(), h + 1);
+	chunks_sub_from(z1.data(), z1.size(), r, 2 * h);
+	chunks_sub_from(z1.data(), z1.size(), r + 2 * h, n + m - 2 * h);
+	chunks_add_to(r + h, n + m - h, z1.data(),
+	    std::min(z1.size(), n + m - h));
+}
+
+// repeated short division of the 32-bit halves by 10^9
+inline
+chunk_vector limbs_to_chunks_basecase(std::uint64_t const* limbs,
+    std::size_t n)
+{
+	std::vector<std::uint32_t> u(2 * n);
+	chunk_vector r;
+
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		u[2 * i] = std::uint32_t(limbs[i]);
+		u[2 * i + 1] = std::uint32_t(limbs[i] >> 32);
+	}
+
+	auto m = u.size();
+
+	for (;;)
+	{
+		while (m and u[m - 1] == 0)
+			--m;
+
+		if (m == 0)
+			return r;
+
+		std::uint64_t rem = 0;
+
+		for (auto i = m; i--;)
+		{
+			auto t = rem << 32 | u[i];
+			u[i] = std::uint32_t(t / chunk_base);
+			rem = t % chunk_base;
+		}
+
+		r.push_back(std::uint32_t(rem));
+	}
+}
+
+// x = hi * 2^(64h) + lo, where h is a power of 2; hi and lo are
+// converted recursively, and the decimal form of 2^(64h) is taken from
+// pows, the repeated squares of 2^64.  With Karatsuba multiplication
+// the whole conversion is O(n^1.59 log n).
+inline
+chunk_vector limbs_to_chunks(std::uint64_t const* limbs, std::size_t n,
+    std::vector<chunk_vector>& pows)
+{
+	if (n <= radix_dc_threshold)
+		return limbs_to_chunks_basecase(limbs, n);
+
+	std::size_t k = 0;
+
+	while ((std::size_t(2) << k) < n)
+		++k;
+
+	while (pows.size() <= k)
+	{
+		if (pows.empty())
+		{
+			pows.push_back({ 709551616, 446744073, 18 });
+			continue;
+		}
+
+		auto& b = pows.back();
+		chunk_vector sq(2 * b.size());
+
+		chunks_mul(sq.data(), b.data(), b.size(), b.data(), b.size());
+		trim_chunks(sq);
+		pows.push_back(std::move(sq));
+	}
+
+	auto h = std::size_t(1) << k;
+	auto lo = limbs_to_chunks(limbs, h, pows);
+	auto hi = limbs_to_chunks(limbs + h, n - h, pows);
+	auto& b = pows[k];
+	chunk_vector r(hi.size() + b.size());
+
+	chunks_mul(r.data(), hi.data(), hi.size(), b.data(), b.size());
+	chunks_add_to(r.data(), r.size(), lo.data(), lo.size());
+	trim_chunks(r);
+
+	return r;
+}
+
+// the base 10^9 chunks of a magnitude without leading zero limbs
+inline
+chunk_vector limbs_to_chunks(std::uint64_t const* limbs, std::size_t n)
+{
+	std::vector<chunk_vector> pows;
+
+	return limbs_to_chunks(limbs, n, pows);
+}
+
+}
+}
+
+#endif
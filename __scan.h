@@ -0,0 +1,523 @@
+/*-
+ * Copyright (c) 2013 Zhihao Yuan.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _STDEX___SCAN_H
+#define _STDEX___SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace stdex {
+
+namespace detail {
+
+inline
+int count_trailing_zeros(std::uint64_t n)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(n);
+#else
+	int w = 0;
+
+	for (; (n & 1) == 0; n >>= 1)
+		++w;
+
+	return w;
+#endif
+}
+
+// The scan<Match, K> kernels return the offset of the first character
+// in [p + i, p + n) which equals (Match) or differs from (not Match)
+// all of the K characters in set, or n.
+
+template <bool Match, std::size_t K, typename CharT>
+inline
+bool scan_hit(CharT c, CharT const* set)
+{
+	bool found = false;
+
+	for (std::size_t k = 0; k < K; ++k)
+		found = found or c == set[k];
+
+	return found == Match;
+}
+
+template <bool Match, std::size_t K, typename CharT>
+inline
+std::size_t scan_scalar(CharT const* p, std::size_t i, std::size_t n,
+    CharT const* set)
+{
+	for (; i < n; ++i)
+		if (scan_hit<Match, K>(p[i], set))
+			break;
+
+	return i;
+}
+
+template <typename CharT>
+constexpr
+std::uint64_t lane_splat(CharT c)
+{
+	return ~std::uint64_t(0) /
+	    ((std::uint64_t(1) << 8 * sizeof(CharT)) - 1) *
+	    typename std::make_unsigned<CharT>::type(c);
+}
+
+// Eight bytes at a time: in a lane x, ((x & 0x7f) + 0x7f) | x has
+// its top bit set iff x is not zero, and the sum never carries into
+// the next lane.
+template <bool Match, std::size_t K, typename CharT>
+inline
+std::size_t scan_swar(CharT const* p, std::size_t i, std::size_t n,
+    CharT const* set)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	constexpr int bits = 8 * sizeof(CharT);
+	constexpr std::size_t lanes = 8 / sizeof(CharT);
+	constexpr std::uint64_t hi = lane_splat(CharT(1)) << (bits - 1);
+
+	std::uint64_t splat[K];
+
+	for (std::size_t k = 0; k < K; ++k)
+		splat[k] = lane_splat(set[k]);
+
+	for (; i + lanes <= n; i += lanes)
+	{
+		std::uint64_t v;
+		std::memcpy(&v, p + i, 8);
+
+		std::uint64_t nz = hi;
+
+		for (std::size_t k = 0; k < K; ++k)
+		{
+			auto a = v ^ splat[k];
+			nz &= ((a & ~hi) + ~hi) | a;
+		}
+
+		auto z = Match ? ~nz & hi : nz;
+
+		if (z != 0)
+			return i + count_trailing_zeros(z) / bits;
+	}
+#endif
+
+	return scan_scalar<Match, K>(p, i, n, set);
+}
+
+// The vector kernels advance i over whole registers and return true
+// with i pointing at a hit, or false with fewer than a register left.
+
+template <typename Ops, bool Match, std::size_t K, typename CharT>
+inline
+bool scan_lanes(CharT const* p, std::size_t& i, std::size_t n,
+    CharT const* set)
+{
+	constexpr std::size_t lanes = Ops::width / sizeof(CharT);
+
+	typename Ops::type splat[K];
+
+	for (std::size_t k = 0; k < K; ++k)
+		splat[k] = Ops::splat(set[k]);
+
+	for (; i + lanes <= n; i += lanes)
+	{
+		auto v = Ops::load(p + i);
+		auto m = Ops::equal(v, splat[0]);
+
+		for (std::size_t k = 1; k < K; ++k)
+			m = Ops::either(m, Ops::equal(v, splat[k]));
+
+		auto bits = Ops::mask(m);
+
+		if (not Match)
+			bits ^= Ops::full;
+
+		if (bits != 0)
+		{
+			i += count_trailing_zeros(bits) / sizeof(CharT);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Candidates are the offsets where both the first and the last
+// characters of the needle match; only those are compared in full.
+template <typename Ops, typename CharT>
+inline
+bool search_lanes(CharT const* p, std::size_t& i, std::size_t n,
+    CharT const* s, std::size_t m)
+{
+	constexpr std::size_t lanes = Ops::width / sizeof(CharT);
+	constexpr unsigned lane_mask = (1u << sizeof(CharT)) - 1;
+
+	auto first = Ops::splat(s[0]);
+	auto last = Ops::splat(s[m - 1]);
+
+	for (; i + m - 1 + lanes <= n; i += lanes)
+	{
+		auto bits = Ops::mask(Ops::both(
+		    Ops::equal(Ops::load(p + i), first),
+		    Ops::equal(Ops::load(p + i + m - 1), last)));
+
+		while (bits != 0)
+		{
+			auto j = count_trailing_zeros(bits) / sizeof(CharT);
+
+			if (std::memcmp(p + i + j + 1, s + 1,
+			    (m - 2) * sizeof(CharT)) == 0)
+			{
+				i += j;
+				return true;
+			}
+
+			bits &= ~(lane_mask << (j * sizeof(CharT)));
+		}
+	}
+
+	return false;
+}
+
+#if defined(__GNUC__) && defined(__SSE2__)
+
+struct sse2_vector
+{
+	typedef __m128i type;
+	static constexpr std::size_t width = 16;
+	static constexpr unsigned full = 0xffff;
+
+	static __m128i load(void const* p)
+	{
+		return _mm_loadu_si128(static_cast<__m128i const*>(p));
+	}
+
+	static __m128i either(__m128i a, __m128i b)
+	{
+		return _mm_or_si128(a, b);
+	}
+
+	static __m128i both(__m128i a, __m128i b)
+	{
+		return _mm_and_si128(a, b);
+	}
+
+	static unsigned mask(__m128i v)
+	{
+		return unsigned(_mm_movemask_epi8(v));
+	}
+};
+
+template <int Size>
+struct sse2_lanes;
+
+template <>
+struct sse2_lanes<1> : sse2_vector
+{
+	static __m128i splat(int c)
+	{
+		return _mm_set1_epi8(char(c));
+	}
+
+	static __m128i equal(__m128i a, __m128i b)
+	{
+		return _mm_cmpeq_epi8(a, b);
+	}
+};
+
+template <>
+struct sse2_lanes<2> : sse2_vector
+{
+	static __m128i splat(int c)
+	{
+		return _mm_set1_epi16(short(c));
+	}
+
+	static __m128i equal(__m128i a, __m128i b)
+	{
+		return _mm_cmpeq_epi16(a, b);
+	}
+};
+
+template <>
+struct sse2_lanes<4> : sse2_vector
+{
+	static __m128i splat(int c)
+	{
+		return _mm_set1_epi32(c);
+	}
+
+	static __m128i equal(__m128i a, __m128i b)
+	{
+		return _mm_cmpeq_epi32(a, b);
+	}
+};
+
+#endif
+
+#if defined(__GNUC__) && defined(__AVX2__)
+
+struct avx2_vector
+{
+	typedef __m256i type;
+	static constexpr std::size_t width = 32;
+	static constexpr unsigned full = 0xffffffff;
+
+	static __m256i load(void const* p)
+	{
+		return _mm256_loadu_si256(static_cast<__m256i const*>(p));
+	}
+
+	static __m256i either(__m256i a, __m256i b)
+	{
+		return _mm256_or_si256(a, b);
+	}
+
+	static __m256i both(__m256i a, __m256i b)
+	{
+		return _mm256_and_si256(a, b);
+	}
+
+	static unsigned mask(__m256i v)
+	{
+		return unsigned(_mm256_movemask_epi8(v));
+	}
+};
+
+template <int Size>
+struct avx2_lanes;
+
+template <>
+struct avx2_lanes<1> : avx2_vector
+{
+	static __m256i splat(int c)
+	{
+		return _mm256_set1_epi8(char(c));
+	}
+
+	static __m256i equal(__m256i a, __m256i b)
+	{
+		return _mm256_cmpeq_epi8(a, b);
+	}
+};
+
+template <>
+struct avx2_lanes<2> : avx2_vector
+{
+	static __m256i splat(int c)
+	{
+		return _mm256_set1_epi16(short(c));
+	}
+
+	static __m256i equal(__m256i a, __m256i b)
+	{
+		return _mm256_cmpeq_epi16(a, b);
+	}
+};
+
+template <>
+struct avx2_lanes<4> : avx2_vector
+{
+	static __m256i splat(int c)
+	{
+		return _mm256_set1_epi32(c);
+	}
+
+	static __m256i equal(__m256i a, __m256i b)
+	{
+		return _mm256_cmpeq_epi32(a, b);
+	}
+};
+
+#endif
+
+// the kernel is picked at compile time by the instruction sets enabled
+template <bool Match, std::size_t K, typename CharT>
+inline
+std::size_t scan(CharT const* p, std::size_t i, std::size_t n,
+    CharT const* set)
+{
+	static_assert(sizeof(CharT) <= 4, "unsupported character type");
+
+#if defined(__GNUC__) && defined(__AVX2__)
+	if (scan_lanes<avx2_lanes<sizeof(CharT)>, Match, K>(p, i, n, set))
+		return i;
+#endif
+#if defined(__GNUC__) && defined(__SSE2__)
+	if (scan_lanes<sse2_lanes<sizeof(CharT)>, Match, K>(p, i, n, set))
+		return i;
+#endif
+
+	return scan_swar<Match, K>(p, i, n, set);
+}
+
+// the offset of the first '{' or '}' in [p, p + n), or n
+template <typename CharT>
+inline
+std::size_t find_brace(CharT const* p, std::size_t n)
+{
+	CharT const braces[] = { CharT('{'), CharT('}') };
+
+	return scan<true, 2>(p, 0, n, braces);
+}
+
+template <typename CharT>
+inline
+std::size_t find_char(CharT const* p, std::size_t i, std::size_t n,
+    CharT c)
+{
+	return scan<true, 1>(p, i, n, &c);
+}
+
+inline
+std::size_t find_char(char const* p, std::size_t i, std::size_t n, char c)
+{
+	auto q = static_cast<char const*>(std::memchr(p + i, c, n - i));
+
+	return q == nullptr ? n : q - p;
+}
+
+// One bit per character below 256; the wider characters of a set, if
+// any, are looked up linearly.
+template <typename CharT>
+struct char_bitmap
+{
+	typedef typename std::make_unsigned<CharT>::type unsigned_type;
+
+	char_bitmap(CharT const* set, std::size_t k) :
+		set_(set), k_(k), wide_(false), bits_()
+	{
+		for (std::size_t j = 0; j < k; ++j)
+		{
+			auto u = unsigned_type(set[j]);
+
+			if (u < 256)
+				bits_[u >> 6] |= std::uint64_t(1) << (u & 63);
+			else
+				wide_ = true;
+		}
+	}
+
+	bool contains(CharT c) const
+	{
+		auto u = unsigned_type(c);
+
+		if (u < 256)
+			return (bits_[u >> 6] >> (u & 63)) & 1;
+
+		if (wide_)
+			for (std::size_t j = 0; j < k_; ++j)
+				if (set_[j] == c)
+					return true;
+
+		return false;
+	}
+
+private:
+	CharT const* set_;
+	std::size_t k_;
+	bool wide_;
+	std::uint64_t bits_[4];
+};
+
+// the offset of the first character in [p + i, p + n) which is in
+// (Match) or not in (not Match) the k characters of set, or n
+template <bool Match, typename CharT>
+inline
+std::size_t find_of(CharT const* p, std::size_t i, std::size_t n,
+    CharT const* set, std::size_t k)
+{
+	switch (k)
+	{
+	case 0:
+		return Match ? n : i;
+	case 1:
+		return Match ? find_char(p, i, n, *set) :
+		    scan<false, 1>(p, i, n, set);
+	case 2:
+		return scan<Match, 2>(p, i, n, set);
+	case 3:
+		return scan<Match, 3>(p, i, n, set);
+	case 4:
+		return scan<Match, 4>(p, i, n, set);
+	}
+
+	char_bitmap<CharT> bm(set, k);
+
+	for (; i < n; ++i)
+		if (bm.contains(p[i]) == Match)
+			break;
+
+	return i;
+}
+
+template <typename CharT>
+inline
+std::size_t search_scalar(CharT const* p, std::size_t i, std::size_t n,
+    CharT const* s, std::size_t m)
+{
+	for (; i + m <= n; ++i)
+		if (p[i] == s[0] and p[i + m - 1] == s[m - 1] and
+		    std::memcmp(p + i + 1, s + 1,
+		    (m - 2) * sizeof(CharT)) == 0)
+			return i;
+
+	return n;
+}
+
+// the offset of the first [s, s + m) in [p + i, p + n), or n; m >= 2
+template <typename CharT>
+inline
+std::size_t search(CharT const* p, std::size_t i, std::size_t n,
+    CharT const* s, std::size_t m)
+{
+	static_assert(sizeof(CharT) <= 4, "unsupported character type");
+
+#if defined(__GNUC__) && defined(__AVX2__)
+	if (search_lanes<avx2_lanes<sizeof(CharT)>>(p, i, n, s, m))
+		return i;
+#endif
+#if defined(__GNUC__) && defined(__SSE2__)
+	if (search_lanes<sse2_lanes<sizeof(CharT)>>(p, i, n, s, m))
+		return i;
+#endif
+
+	return search_scalar(p, i, n, s, m);
+}
+
+}
+}
+
+#endif
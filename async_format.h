@@ -0,0 +1,639 @@
+/*-
+ * Copyright (c) 2013 Zhihao Yuan.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _STDEX_ASYNC_FORMAT_H
+#define _STDEX_ASYNC_FORMAT_H
+
+#include "ostream_format.h"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <tuple>
+#include <new>
+#include <memory>
+#include <cstdint>
+#include <type_traits>
+
+namespace stdex {
+
+// what a producer does when the queue is full
+enum class overflow_policy
+{
+	block,	// waits for room
+	drop,	// discards the message
+	grow,	// queues it in an unbounded list, behind a lock
+};
+
+namespace detail {
+
+// the type an argument is copied into until the consumer formats it;
+// strings the caller may change or free are copied
+template <typename T>
+struct async_stored
+{
+	using type = T;
+};
+
+template <typename CharT, typename Traits>
+struct async_stored<basic_string_view<CharT, Traits>>
+{
+	using type = std::basic_string<CharT, Traits>;
+};
+
+template <typename CharT>
+struct async_stored_chars
+{
+	using type = std::basic_string<CharT>;
+};
+
+template <>
+struct async_stored<char const*> : async_stored_chars<char> {};
+
+template <>
+struct async_stored<wchar_t const*> : async_stored_chars<wchar_t> {};
+
+template <>
+struct async_stored<char16_t const*> : async_stored_chars<char16_t> {};
+
+template <>
+struct async_stored<char32_t const*> : async_stored_chars<char32_t> {};
+
+template <>
+struct async_stored<char*> : async_stored_chars<char> {};
+
+template <>
+struct async_stored<wchar_t*> : async_stored_chars<wchar_t> {};
+
+template <>
+struct async_stored<char16_t*> : async_stored_chars<char16_t> {};
+
+template <>
+struct async_stored<char32_t*> : async_stored_chars<char32_t> {};
+
+template <typename T>
+using async_stored_t = typename async_stored<typename std::decay<T>::type>::type;
+
+// A captured message: the arguments, followed in memory by the
+// characters of the format string.
+template <typename Writer, typename Tuple>
+struct async_payload
+{
+	using char_type = typename Writer::char_type;
+
+	template <typename... T>
+	async_payload(basic_string_view<char_type> fmt, T&&... t) :
+		args(std::forward<T>(t)...), fmt_size(fmt.size())
+	{
+		std::copy(fmt.begin(), fmt.end(), chars());
+	}
+
+	static std::size_t size_for(basic_string_view<char_type> fmt)
+	{
+		return sizeof(async_payload) + fmt.size() * sizeof(char_type);
+	}
+
+	// formats the message with *w, if w is not null, then destroys it
+	static bool consume(void* p, Writer* w)
+	{
+		auto& m = *static_cast<async_payload*>(p);
+
+		struct guard
+		{
+			~guard()
+			{
+				m.~async_payload();
+			}
+
+			async_payload& m;
+		} _{ m };
+
+		return w != nullptr and m.apply(*w, std::make_index_sequence<
+		    std::tuple_size<Tuple>::value>());
+	}
+
+private:
+	template <std::size_t... I>
+	bool apply(Writer& w, std::index_sequence<I...>)
+	{
+		return w(basic_string_view<char_type>(chars(), fmt_size),
+		    std::get<I>(args)...);
+	}
+
+	char_type* chars()
+	{
+		return reinterpret_cast<char_type*>(this + 1);
+	}
+
+	Tuple args;
+	std::size_t fmt_size;
+};
+
+}
+
+// Formats and writes to a stream on a thread of its own.  A call
+// copies the format string and the arguments into a bounded lock-free
+// queue (Vyukov's, with one slot per message) and returns; the
+// consumer thread formats each message with an ostream_format, which
+// is the only user of the stream.  When the queue is full, the
+// overflow_policy decides.  Messages from one thread are written in
+// the order they were made; flush() returns when everything queued
+// before it has been written and the stream flushed, and so does the
+// destructor, which stops the consumer.
+template <typename CharT, typename Traits = std::char_traits<CharT>>
+struct async_ostream_format
+{
+	using char_type = CharT;
+	using traits_type = Traits;
+	using ostream_type = std::basic_ostream<CharT, Traits>;
+
+	explicit async_ostream_format(ostream_type& out,
+	    std::size_t capacity = 1024,
+	    overflow_policy policy = overflow_policy::block) :
+		writer_(out),
+		out_(out),
+		policy_(policy),
+		mask_(pow2_capacity(capacity) - 1),
+		storage_(new unsigned char[(mask_ + 1) * sizeof(slot) +
+		    alignof(slot) - 1]),
+		slots_(align_slots(storage_.get()))
+	{
+		for (std::size_t i = 0; i <= mask_; ++i)
+		{
+			::new (&slots_[i]) slot;
+			slots_[i].seq.store(i, std::memory_order_relaxed);
+		}
+
+		consumer_ = std::thread([this] { run(); });
+	}
+
+	async_ostream_format(async_ostream_format const&) = delete;
+	async_ostream_format& operator=(async_ostream_format const&) = delete;
+
+	~async_ostream_format()
+	{
+		{
+			std::lock_guard<std::mutex> lk(mtx_);
+			stop_.store(true, std::memory_order_release);
+		}
+
+		work_cv_.notify_one();
+		consumer_.join();
+	}
+
+	// false if the message was dropped
+	template <typename... T>
+	bool operator()(basic_string_view<CharT> fmt, T&&... t)
+	{
+		using payload = detail::async_payload<writer_type,
+		    std::tuple<detail::async_stored_t<T>...>>;
+
+		return push(payload::size_for(fmt), &payload::consume,
+		    [&](void* p)
+		    {
+			::new (p) payload(fmt, std::forward<T>(t)...);
+		    });
+	}
+
+	void flush()
+	{
+		std::unique_lock<std::mutex> lk(mtx_);
+		auto ticket = ++flush_requested_;
+
+		work_cv_.notify_one();
+		done_cv_.wait(lk, [&] { return flush_done_ >= ticket; });
+	}
+
+	// the messages discarded under overflow_policy::drop
+	std::uint64_t dropped() const
+	{
+		return dropped_.load(std::memory_order_relaxed);
+	}
+
+	// the messages which failed to format or to be written
+	std::uint64_t failed() const
+	{
+		return failed_.load(std::memory_order_relaxed);
+	}
+
+private:
+	using writer_type = ostream_format<CharT, Traits, std::allocator<CharT>>;
+	using consume_fn = bool (*)(void*, writer_type*);
+
+	static constexpr std::size_t inline_size = 224;
+
+	struct alignas(64) slot
+	{
+		std::atomic<std::size_t> seq;
+		consume_fn consume;
+		void* heap;
+		alignas(std::max_align_t) unsigned char storage[inline_size];
+	};
+
+	static_assert(std::is_trivially_destructible<slot>::value,
+	    "slots are never destroyed");
+
+	// new[] before C++17 does not honor the alignment of slot
+	static slot* align_slots(unsigned char* p)
+	{
+		auto a = alignof(slot);
+		auto u = reinterpret_cast<std::uintptr_t>(p);
+
+		return reinterpret_cast<slot*>((u + a - 1) / a * a);
+	}
+
+	// a message which did not fit in the queue
+	struct spilled
+	{
+		consume_fn consume;
+		void* heap;
+	};
+
+	static std::size_t pow2_capacity(std::size_t n)
+	{
+		return detail::pow2_roundup(std::max<std::size_t>(n, 2));
+	}
+
+	template <typename Build>
+	bool push(std::size_t size, consume_fn consume, Build build)
+	{
+		bool fits = size <= inline_size;
+		void* heap = nullptr;
+
+		if (not fits)
+			heap = make_heap(size, build);
+
+		for (;;)
+		{
+			if (not spilling_.load(std::memory_order_acquire))
+			{
+				if (auto s = claim())
+				{
+					publish(*s, consume, heap, build);
+					return true;
+				}
+			}
+
+			switch (policy_)
+			{
+			case overflow_policy::block:
+				wait_for_space();
+				continue;
+			case overflow_policy::drop:
+				if (heap != nullptr)
+					discard(consume, heap);
+
+				dropped_.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			case overflow_policy::grow:
+				spill(consume, heap != nullptr ? heap :
+				    make_heap(size, build));
+				return true;
+			}
+		}
+	}
+
+	template <typename Build>
+	static void* make_heap(std::size_t size, Build& build)
+	{
+		auto p = ::operator new(size);
+
+		try
+		{
+			build(p);
+		}
+		catch (...)
+		{
+			::operator delete(p);
+			throw;
+		}
+
+		return p;
+	}
+
+	static void discard(consume_fn consume, void* heap)
+	{
+		consume(heap, nullptr);
+		::operator delete(heap);
+	}
+
+	slot* claim()
+	{
+		auto pos = tail_.load(std::memory_order_relaxed);
+
+		for (;;)
+		{
+			auto& s = slots_[pos & mask_];
+			auto seq = s.seq.load(std::memory_order_acquire);
+			auto dif = std::ptrdiff_t(seq - pos);
+
+			if (dif == 0)
+			{
+				if (tail_.compare_exchange_weak(pos, pos + 1,
+				    std::memory_order_relaxed))
+					return &s;
+			}
+			else if (dif < 0)
+				return nullptr;
+			else
+				pos = tail_.load(std::memory_order_relaxed);
+		}
+	}
+
+	template <typename Build>
+	void publish(slot& s, consume_fn consume, void* heap, Build& build)
+	{
+		auto pos = s.seq.load(std::memory_order_relaxed);
+
+		// a claimed slot is always published, if only as a blank
+		s.consume = nullptr;
+		s.heap = heap;
+
+		if (heap == nullptr)
+		{
+			try
+			{
+				build(s.storage);
+			}
+			catch (...)
+			{
+				s.seq.store(pos + 1, std::memory_order_release);
+				throw;
+			}
+		}
+
+		s.consume = consume;
+		s.seq.store(pos + 1, std::memory_order_release);
+		wake_if_idle();
+	}
+
+	void spill(consume_fn consume, void* heap)
+	{
+		{
+			std::lock_guard<std::mutex> lk(mtx_);
+
+			spill_.push_back({ consume, heap });
+			spilling_.store(true, std::memory_order_release);
+		}
+
+		work_cv_.notify_one();
+	}
+
+	void wake_if_idle()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if (idle_.load(std::memory_order_relaxed))
+			wake();
+	}
+
+	void wake()
+	{
+		std::lock_guard<std::mutex> lk(mtx_);
+		work_cv_.notify_one();
+	}
+
+	// A producer finding the queue full sleeps until the consumer frees
+	// a slot.  It counts itself in waiters_ before looking, and the
+	// consumer looks at waiters_ after freeing, so one of them sees the
+	// other.
+	void wait_for_space()
+	{
+		waiters_.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		{
+			std::unique_lock<std::mutex> lk(mtx_);
+			work_cv_.notify_one();
+			space_cv_.wait(lk, [&] { return has_space(); });
+		}
+
+		waiters_.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	bool has_space() const
+	{
+		auto pos = tail_.load(std::memory_order_relaxed);
+		auto& s = slots_[pos & mask_];
+
+		return std::ptrdiff_t(s.seq.load(std::memory_order_acquire) -
+		    pos) >= 0;
+	}
+
+	void slot_freed()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if (waiters_.load(std::memory_order_relaxed) != 0)
+		{
+			std::lock_guard<std::mutex> lk(mtx_);
+			space_cv_.notify_one();
+		}
+	}
+
+	bool ready() const
+	{
+		auto& s = slots_[head_ & mask_];
+
+		return s.seq.load(std::memory_order_acquire) == head_ + 1;
+	}
+
+	void consume(consume_fn f, void* p)
+	{
+		try
+		{
+			if (not f(p, &writer_))
+				failed_.fetch_add(1, std::memory_order_relaxed);
+		}
+		catch (...)
+		{
+			failed_.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		recover();
+	}
+
+	// ostream_format reports a message which failed to format with
+	// failbit; no one but this thread may clear it, and the messages
+	// after it would all be refused.  badbit stays.
+	void recover()
+	{
+		auto st = out_.rdstate();
+
+		if ((st & ostream_type::failbit) and
+		    not (st & ostream_type::badbit))
+		{
+			try
+			{
+				out_.clear(st & ~ostream_type::failbit);
+			}
+			catch (...)
+			{
+			}
+		}
+	}
+
+	// Writes the messages in the queue, then those spilled.  The spill
+	// list is taken first: a message queued before a spilled one from
+	// the same thread has been claimed by then, so it is written first.
+	// New messages are queued again once the spill list runs dry.
+	bool drain()
+	{
+		std::vector<spilled> batch;
+
+		if (spilling_.load(std::memory_order_acquire))
+		{
+			std::lock_guard<std::mutex> lk(mtx_);
+			batch.swap(spill_);
+		}
+
+		auto end = tail_.load(std::memory_order_acquire);
+		bool any = head_ != end or not batch.empty();
+
+		for (; head_ != end; ++head_)
+		{
+			while (not ready())
+				std::this_thread::yield();
+
+			auto& s = slots_[head_ & mask_];
+
+			if (s.consume != nullptr)
+				consume(s.consume, s.heap != nullptr ? s.heap :
+				    s.storage);
+
+			if (s.heap != nullptr)
+				::operator delete(s.heap);
+
+			s.seq.store(head_ + mask_ + 1,
+			    std::memory_order_release);
+			slot_freed();
+		}
+
+		for (auto& m : batch)
+		{
+			consume(m.consume, m.heap);
+			::operator delete(m.heap);
+		}
+
+		if (not batch.empty())
+		{
+			std::lock_guard<std::mutex> lk(mtx_);
+
+			if (spill_.empty())
+				spilling_.store(false,
+				    std::memory_order_release);
+		}
+
+		return any;
+	}
+
+	bool has_work() const
+	{
+		return ready() or spilling_.load(std::memory_order_acquire) or
+		    stop_.load(std::memory_order_acquire) or
+		    flush_requested_ != flush_done_;
+	}
+
+	void run()
+	{
+		for (;;)
+		{
+			std::uint64_t req;
+			bool stopping;
+
+			{
+				std::lock_guard<std::mutex> lk(mtx_);
+				req = flush_requested_;
+				stopping = stop_.load(
+				    std::memory_order_relaxed);
+			}
+
+			bool any = drain();
+
+			if (req != flush_done_ or stopping)
+			{
+				try
+				{
+					out_.flush();
+				}
+				catch (...)
+				{
+				}
+
+				std::lock_guard<std::mutex> lk(mtx_);
+				flush_done_ = req;
+				done_cv_.notify_all();
+			}
+
+			if (stopping)
+				return;
+
+			if (not any)
+				idle();
+		}
+	}
+
+	void idle()
+	{
+		idle_.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		{
+			std::unique_lock<std::mutex> lk(mtx_);
+			work_cv_.wait(lk, [&] { return has_work(); });
+		}
+
+		idle_.store(false, std::memory_order_relaxed);
+	}
+
+	writer_type writer_;
+	ostream_type& out_;
+	overflow_policy const policy_;
+	std::size_t const mask_;
+	std::unique_ptr<unsigned char[]> storage_;
+	slot* const slots_;
+	alignas(64) std::atomic<std::size_t> tail_{ 0 };
+	alignas(64) std::size_t head_ = 0;
+	std::atomic<bool> idle_{ false };
+	std::atomic<int> waiters_{ 0 };
+	std::atomic<bool> spilling_{ false };
+	std::atomic<bool> stop_{ false };
+	std::atomic<std::uint64_t> dropped_{ 0 };
+	std::atomic<std::uint64_t> failed_{ 0 };
+	std::mutex mtx_;
+	std::condition_variable work_cv_;
+	std::condition_variable done_cv_;
+	std::condition_variable space_cv_;
+	std::uint64_t flush_requested_ = 0;	// guarded by mtx_
+	std::uint64_t flush_done_ = 0;		// guarded by mtx_
+	std::vector<spilled> spill_;		// guarded by mtx_
+	std::thread consumer_;
+};
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+/*-
+ * Copyright (c) 2013 Zhihao Yuan.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _STDEX_BENCH_H
+#define _STDEX_BENCH_H
+
+#include <chrono>
+#include <cstdio>
+
+// prevents the optimizer from discarding a result
+template <typename T>
+inline
+void keep(T const& v)
+{
+#if defined(__GNUC__)
+	asm volatile("" : : "g"(&v) : "memory");
+#else
+	static volatile char sink;
+	sink = *reinterpret_cast<char const volatile*>(&v);
+#endif
+}
+
+// runs f(i) for i in [0, n) and prints the mean time per call
+template <typename F>
+inline
+void run(char const* name, long n, F f)
+{
+	using clock = std::chrono::steady_clock;
+
+	for (long i = 0; i < n / 16; ++i)
+		f(i);
+
+	auto t0 = clock::now();
+
+	for (long i = 0; i < n; ++i)
+		f(i);
+
+	std::chrono::duration<double, std::nano> d = clock::now() - t0;
+
+	std::printf("%-32s %8.2f ns\n", name, d.count() / n);
+}
+
+#endif
@@ -0,0 +1,106 @@
+#include "../format_arena.h"
+
+#include "bench.h"
+
+#include <string>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<memory_resource>) && __cplusplus >= 201703L
+#include <memory_resource>
+#define HAS_PMR
+#endif
+#endif
+
+// the strings a request handler might build; one call is one request
+// of 24 strings, most too long for the small string optimization
+
+int main()
+{
+	long const n = 1 << 16;
+	std::string host = "backend-17.example.internal";
+	std::vector<std::string> owned;
+	std::vector<stdex::string_view> views;
+
+	run("format x24", n, [&](long i)
+	    {
+		owned.clear();
+
+		for (int j = 0; j < 8; ++j)
+		{
+			owned.push_back(stdex::format("X-Request-Id: {}-{}",
+			    i, j));
+			owned.push_back(stdex::format("Host: {}:{}", host,
+			    8000 + j));
+			owned.push_back(stdex::format("/api/v1/items/{}?page={}",
+			    i * 31, j));
+		}
+
+		keep(owned);
+	    });
+
+	stdex::format_arena a;
+
+	run("format_into_arena x24", n, [&](long i)
+	    {
+		a.reset();
+		views.clear();
+
+		for (int j = 0; j < 8; ++j)
+		{
+			views.push_back(format_into_arena(a,
+			    "X-Request-Id: {}-{}", i, j));
+			views.push_back(format_into_arena(a,
+			    "Host: {}:{}", host, 8000 + j));
+			views.push_back(format_into_arena(a,
+			    "/api/v1/items/{}?page={}", i * 31, j));
+		}
+
+		keep(views);
+	    });
+
+#if defined(HAS_PMR)
+	char buf[4096];
+
+	run("format_into_arena x24, pmr", n, [&](long i)
+	    {
+		std::pmr::monotonic_buffer_resource mr(buf, sizeof(buf));
+		stdex::format_arena a(&mr);
+
+		views.clear();
+
+		for (int j = 0; j < 8; ++j)
+		{
+			views.push_back(format_into_arena(a,
+			    "X-Request-Id: {}-{}", i, j));
+			views.push_back(format_into_arena(a,
+			    "Host: {}:{}", host, 8000 + j));
+			views.push_back(format_into_arena(a,
+			    "/api/v1/items/{}?page={}", i * 31, j));
+		}
+
+		keep(views);
+	    });
+
+	std::vector<std::pmr::string> pmr_owned;
+
+	run("format pmr::string x24", n, [&](long i)
+	    {
+		std::pmr::monotonic_buffer_resource mr(buf, sizeof(buf));
+		std::pmr::polymorphic_allocator<char> alloc(&mr);
+
+		for (int j = 0; j < 8; ++j)
+		{
+			pmr_owned.push_back(stdex::format(alloc,
+			    "X-Request-Id: {}-{}", i, j));
+			pmr_owned.push_back(stdex::format(alloc,
+			    "Host: {}:{}", host, 8000 + j));
+			pmr_owned.push_back(stdex::format(alloc,
+			    "/api/v1/items/{}?page={}", i * 31, j));
+		}
+
+		keep(pmr_owned);
+		pmr_owned.clear();
+	    });
+#endif
+}
@@ -0,0 +1,47 @@
+#include "../async_format.h"
+
+#include "bench.h"
+
+#include <fstream>
+#include <string>
+
+// the time a producer spends per call; the queue is large enough that
+// the async front end never waits for its consumer
+
+int main()
+{
+	long const n = 1 << 17;
+	std::ofstream out("/dev/null");
+	std::string path = "/api/v1/items/1234?page=7";
+
+	{
+		auto log = stdex::make_formatted(out);
+
+		run("ostream_format", n, [&](long i)
+		    {
+			log("{} GET {} {} {:>8} bytes {:.3f} ms\n", i, path,
+			    200 + (i & 3), i * 17, i * 0.001);
+		    });
+	}
+
+	{
+		stdex::async_ostream_format<char> log(out, 2 * n);
+
+		run("async_ostream_format", n, [&](long i)
+		    {
+			log("{} GET {} {} {:>8} bytes {:.3f} ms\n", i, path,
+			    200 + (i & 3), i * 17, i * 0.001);
+		    });
+	}
+
+	{
+		stdex::async_ostream_format<char> log(out, 2 * n);
+		char const* name = "items";
+
+		run("async_ostream_format, SSO args", n, [&](long i)
+		    {
+			log("{} GET {} {} {:>8} bytes {:.3f} ms\n", i, name,
+			    200 + (i & 3), i * 17, i * 0.001);
+		    });
+	}
+}
@@ -0,0 +1,52 @@
+#include "../format_cache.h"
+
+#include "bench.h"
+
+#include <string>
+
+int main()
+{
+	long const n = 1 << 22;
+	std::string s;
+	char const* name = "worker";
+
+	// as if loaded from a configuration file
+	std::string fmt = "[{:<8}] request {} took {:.3f} ms ({})";
+
+	run("vsformat log line", n, [&](long i)
+	    {
+		double ms = i * 0.001;
+		int code = int(i & 7);
+
+		s.clear();
+		stdex::detail::vsformat(s, stdex::string_view(fmt),
+		    std::forward_as_tuple(name, i, ms, code));
+		keep(s);
+	    });
+
+	auto& cache = stdex::format_cache::global();
+
+	run("cached log line", n, [&](long i)
+	    {
+		double ms = i * 0.001;
+		int code = int(i & 7);
+
+		s.clear();
+		cache.visit(fmt, [&](stdex::detail::parsed_format<char> const& f)
+		    {
+			stdex::detail::vsformat(s, f,
+			    std::forward_as_tuple(name, i, ms, code));
+		    });
+		keep(s);
+	    });
+
+	run("cached_format log line", n, [&](long i)
+	    {
+		keep(stdex::cached_format(fmt, name, i, i * 0.001,
+		    int(i & 7)));
+	    });
+
+	std::printf("hits %llu, misses %llu\n",
+	    (unsigned long long)cache.hits(),
+	    (unsigned long long)cache.misses());
+}
@@ -0,0 +1,128 @@
+#include "../format.h"
+
+#include "bench.h"
+
+#include <string>
+
+// A program which formats from many call sites, each with arguments of
+// types of its own, as a server writes its log lines.  format() goes
+// through the packed arguments; vsformat() instantiates a formatting
+// loop for every list of argument types.
+
+struct via_format
+{
+	template <typename... T>
+	std::string operator()(stdex::string_view fmt, T const&... t) const
+	{
+		return stdex::format(fmt, t...);
+	}
+};
+
+struct via_tuple
+{
+	template <typename... T>
+	std::string operator()(stdex::string_view fmt, T const&... t) const
+	{
+		std::string s;
+
+		s.reserve(stdex::detail::pow2_roundup(fmt.size()));
+		stdex::detail::vsformat(s, fmt, std::forward_as_tuple(t...));
+
+		return s;
+	}
+};
+
+template <typename F>
+std::string log_line(F f, long i)
+{
+	std::string user = "someone";
+	char const* host = "10.0.0.1";
+	double ms = i * 0.013;
+	int code = int(i & 7);
+	unsigned port = 8080;
+	bool ok = (i & 1) != 0;
+
+	switch (i & 31)
+	{
+	case 0:
+		return f("accepted connection {} from {}:{}", i, host, port);
+	case 1:
+		return f("user {} logged in", user);
+	case 2:
+		return f("request {} took {:.3f} ms", i, ms);
+	case 3:
+		return f("[{:<8}] status {}", "worker", code);
+	case 4:
+		return f("cache {} hit={} size={}", code, ok, i * 64UL);
+	case 5:
+		return f("{:>12}|{:>12}|{:>12}", i, ms, user);
+	case 6:
+		return f("retrying {} in {} s ({} left)", host, 2.5f, short(code));
+	case 7:
+		return f("queue depth {} of {}", (unsigned short)code, 1024);
+	case 8:
+		return f("checksum {:x} for block {}", unsigned(i * 2654435761u),
+		    i);
+	case 9:
+		return f("{}: {}", "warning", "disk almost full");
+	case 10:
+		return f("closed {} after {} bytes", port, i * 1500LL);
+	case 11:
+		return f("mode {} level {} flag {}", 'r', (signed char)code, ok);
+	case 12:
+		return f("{} {} {} {} {}", i, i + 1, i + 2, i + 3, i + 4);
+	case 13:
+		return f("latency p50={:.2f} p99={:.2f}", ms, ms * 4);
+	case 14:
+		return f("{:<20}{:>10}", user, i);
+	case 15:
+		return f("shard {} owner {} epoch {}", code, host, i * 3U);
+	case 16:
+		return f("parsed {} fields from {}", code, std::string("input"));
+	case 17:
+		return f("timer {} fired {} late", i, 0.25);
+	case 18:
+		return f("heap {}/{} MiB", i & 1023, 4096L);
+	case 19:
+		return f("{} => {}", ok, !ok);
+	case 20:
+		return f("session {:x}-{:x}", unsigned(i), unsigned(i * 7));
+	case 21:
+		return f("{:>*}|", code + 4, "pad");
+	case 22:
+		return f("got {} expected {}", 'y', 'n');
+	case 23:
+		return f("ratio {} of {}", float(ms), ms);
+	case 24:
+		return f("{} of {} workers idle", (unsigned char)code, 16);
+	case 25:
+		return f("txn {} committed at {} by {}", i, i * 10LL, user);
+	case 26:
+		return f("{} {} {}", host, port, ok);
+	case 27:
+		return f("offset {} len {} crc {:x}", i * 4096ULL, 4096, 0xbeefu);
+	case 28:
+		return f("{:<10}|{:<10}|{:<10}", "a", "bb", "ccc");
+	case 29:
+		return f("attempt {}/{} for {}", code, 8L, user);
+	case 30:
+		return f("throughput {:.1f} MB/s", ms * 100);
+	default:
+		return f("shutdown requested by {} ({})", user, code);
+	}
+}
+
+int main()
+{
+	long const n = 1 << 20;
+
+	run("format 32 call sites", n, [&](long i)
+	    {
+		keep(log_line(via_format(), i));
+	    });
+
+	run("vsformat 32 call sites", n, [&](long i)
+	    {
+		keep(log_line(via_tuple(), i));
+	    });
+}
@@ -0,0 +1,89 @@
+#include "../chrono_format.h"
+
+#include "bench.h"
+
+#include <ctime>
+#include <cstdio>
+
+int main()
+{
+	using namespace std::chrono;
+
+	auto t0 = time_point_cast<nanoseconds>(system_clock::now());
+	long const n = 1 << 22;
+	std::string s;
+	char buf[64];
+
+	// a log record every 10us
+	run("gmtime_r + strftime", n, [&](long i)
+	    {
+		auto t = t0 + microseconds(10 * i);
+		auto d = t.time_since_epoch();
+		auto sec = duration_cast<seconds>(d);
+		std::time_t tt = sec.count();
+		std::tm tm;
+
+		gmtime_r(&tt, &tm);
+
+		auto len = std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S",
+		    &tm);
+		std::snprintf(buf + len, sizeof(buf) - len, ".%09lldZ",
+		    (long long)(d - sec).count());
+		keep(buf);
+	    });
+
+	run("vsformat {:%FT%T.%fZ}", n, [&](long i)
+	    {
+		auto t = t0 + microseconds(10 * i);
+
+		s.clear();
+		stdex::detail::vsformat(s,
+		    stdex::string_view("{:%Y-%m-%dT%H:%M:%S.%fZ}"),
+		    std::forward_as_tuple(t));
+		keep(s);
+	    });
+
+	run("vsformat, new second each", n / 16, [&](long i)
+	    {
+		auto t = t0 + seconds(i);
+
+		s.clear();
+		stdex::detail::vsformat(s,
+		    stdex::string_view("{:%Y-%m-%dT%H:%M:%S.%fZ}"),
+		    std::forward_as_tuple(t));
+		keep(s);
+	    });
+
+	std::printf("-- durations\n");
+
+	auto latency = [](long i)
+	{
+		return nanoseconds((i * 2654435761u) % 100000000);
+	};
+
+	run("snprintf %.3fms", n, [&](long i)
+	    {
+		keep(std::snprintf(buf, sizeof(buf), "%.3fms",
+		    latency(i).count() / 1e6));
+	    });
+
+	run("vsformat {:.3ms}", n, [&](long i)
+	    {
+		auto d = latency(i);
+
+		s.clear();
+		stdex::detail::vsformat(s, stdex::string_view("{:.3ms}"),
+		    std::forward_as_tuple(d));
+		keep(s);
+	    });
+
+	run("vsformat {:auto}", n, [&](long i)
+	    {
+		auto d = latency(i);
+
+		s.clear();
+		stdex::detail::vsformat(s, stdex::string_view("{:auto}"),
+		    std::forward_as_tuple(d));
+		keep(s);
+	    });
+}
@@ -0,0 +1,56 @@
+#include "../compiled_format.h"
+
+#include "bench.h"
+
+#include <cstdio>
+
+using namespace stdex::literals;
+
+int main()
+{
+	long const n = 1 << 22;
+	std::string s;
+	char buf[128];
+	char const* name = "worker";
+
+	run("snprintf log line", n, [&](long i)
+	    {
+		keep(std::snprintf(buf, sizeof(buf),
+		    "[%-8s] request %ld took %.3f ms (%d)", name, i,
+		    i * 0.001, int(i & 7)));
+	    });
+
+	run("vsformat log line", n, [&](long i)
+	    {
+		double ms = i * 0.001;
+		int code = int(i & 7);
+
+		s.clear();
+		stdex::detail::vsformat(s, stdex::string_view(
+		    "[{:<8}] request {} took {:.3f} ms ({})"),
+		    std::forward_as_tuple(name, i, ms, code));
+		keep(s);
+	    });
+
+	stdex::compiled_format<char const*, long, double, int> f(
+	    "[{:<8}] request {} took {:.3f} ms ({})");
+
+	run("compiled log line", n, [&](long i)
+	    {
+		s.clear();
+		f.render(s, name, i, i * 0.001, int(i & 7));
+		keep(s);
+	    });
+
+	run("_fmt log line", n, [&](long i)
+	    {
+		double ms = i * 0.001;
+		int code = int(i & 7);
+
+		s.clear();
+		stdex::detail::vsformat(s,
+		    "[{:<8}] request {} took {:.3f} ms ({})"_fmt,
+		    std::forward_as_tuple(name, i, ms, code));
+		keep(s);
+	    });
+}
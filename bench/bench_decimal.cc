@@ -0,0 +1,56 @@
+#include "../decimal.h"
+
+#include "bench.h"
+
+#include <vector>
+#include <random>
+#include <cstdio>
+
+int main()
+{
+	std::mt19937_64 g(42);
+	std::vector<long long> amounts;
+
+	for (int i = 0; i < 1024; ++i)
+		amounts.push_back((long long)(g() % 100000000) - 10000000);
+
+	long const n = 1 << 22;
+	std::string s;
+	char buf[64];
+
+	run("snprintf %.2f", n, [&](long i)
+	    {
+		keep(std::snprintf(buf, sizeof(buf), "%.2f",
+		    amounts[i & 1023] / 100.));
+	    });
+
+	run("vsformat {:.2f} double", n, [&](long i)
+	    {
+		double v = amounts[i & 1023] / 100.;
+
+		s.clear();
+		stdex::detail::vsformat(s, stdex::string_view("{:.2f}"),
+		    std::forward_as_tuple(v));
+		keep(s);
+	    });
+
+	run("vsformat {} cents", n, [&](long i)
+	    {
+		stdex::fixed_decimal<2> v(amounts[i & 1023]);
+
+		s.clear();
+		stdex::detail::vsformat(s, stdex::string_view("{}"),
+		    std::forward_as_tuple(v));
+		keep(s);
+	    });
+
+	run("vsformat {:,.1} cents", n, [&](long i)
+	    {
+		stdex::fixed_decimal<2> v(amounts[i & 1023]);
+
+		s.clear();
+		stdex::detail::vsformat(s, stdex::string_view("{:,.1}"),
+		    std::forward_as_tuple(v));
+		keep(s);
+	    });
+}
@@ -0,0 +1,76 @@
+#include "../format.h"
+
+#include "bench.h"
+
+#include <string>
+#include <array>
+#include <random>
+#include <algorithm>
+
+// Formats every argument of an N-tuple once, in sequence and in a
+// shuffled positional order, where picking the argument for a field
+// cannot be predicted from the previous one.  The arguments cycle
+// through four types.
+
+template <std::size_t I>
+auto value()
+{
+	return std::get<I % 4>(std::make_tuple(int(I), "str", I * 0.5,
+	    unsigned(I)));
+}
+
+template <std::size_t N>
+std::string shuffled_format()
+{
+	std::array<int, N> idx;
+	std::mt19937 gen(N);
+	std::string fmt;
+
+	for (std::size_t i = 0; i < N; ++i)
+		idx[i] = int(i) + 1;
+
+	std::shuffle(idx.begin(), idx.end(), gen);
+
+	for (auto i : idx)
+		fmt += "{" + std::to_string(i) + "} ";
+
+	return fmt;
+}
+
+template <std::size_t N, std::size_t... I>
+void bench(std::index_sequence<I...>)
+{
+	long const n = (1 << 22) / N;
+	auto v = std::make_tuple(value<I>()...);
+	std::string seq, s;
+
+	for (std::size_t i = 0; i < N; ++i)
+		seq += "{} ";
+
+	auto shuffled = shuffled_format<N>();
+	auto name = std::to_string(N) + " args ";
+
+	run((name + "in order").data(), n, [&](long i)
+	    {
+		s.clear();
+		stdex::detail::vsformat(s, stdex::string_view(seq),
+		    std::forward_as_tuple(std::get<I>(v)...));
+		keep(s);
+	    });
+
+	run((name + "shuffled").data(), n, [&](long i)
+	    {
+		s.clear();
+		stdex::detail::vsformat(s, stdex::string_view(shuffled),
+		    std::forward_as_tuple(std::get<I>(v)...));
+		keep(s);
+	    });
+}
+
+int main()
+{
+	bench<1>(std::make_index_sequence<1>());
+	bench<4>(std::make_index_sequence<4>());
+	bench<16>(std::make_index_sequence<16>());
+	bench<64>(std::make_index_sequence<64>());
+}
@@ -0,0 +1,103 @@
+#define _STDEX_TESTING
+#include "../format.h"
+
+#include "bench.h"
+
+#include <vector>
+#include <random>
+#include <cstdio>
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+int main()
+{
+	std::mt19937_64 g(42);
+	std::vector<double> metrics, random;
+
+	for (int i = 0; i < 1024; ++i)
+	{
+		std::uint64_t bits = g();
+		double d;
+
+		std::memcpy(&d, &bits, sizeof(d));
+		metrics.push_back(double(g() % 100000) / 1000);
+		random.push_back(std::isfinite(d) ? d : 0.0);
+	}
+
+	long const n = 1 << 21;
+	std::string s;
+	char buf[64];
+
+	for (auto vp : { &metrics, &random })
+	{
+		auto& v = *vp;
+
+		std::printf("-- %s\n", vp == &metrics ? "metrics" : "random");
+
+		run("snprintf %.17g", n, [&](long i)
+		    {
+			keep(std::snprintf(buf, sizeof(buf), "%.17g",
+			    v[i & 1023]));
+		    });
+
+#if defined(__cpp_lib_to_chars)
+		run("std::to_chars", n, [&](long i)
+		    {
+			keep(std::to_chars(buf, buf + sizeof(buf),
+			    v[i & 1023]));
+		    });
+#endif
+
+		run("vsformat {}", n, [&](long i)
+		    {
+			s.clear();
+			stdex::detail::vsformat(s, stdex::string_view("{}"),
+			    std::forward_as_tuple(v[i & 1023]));
+			keep(s);
+		    });
+
+		run("vsformat {} (float)", n, [&](long i)
+		    {
+			float f = v[i & 1023];
+
+			s.clear();
+			stdex::detail::vsformat(s, stdex::string_view("{}"),
+			    std::forward_as_tuple(f));
+			keep(s);
+		    });
+
+		run("snprintf %.2f", n, [&](long i)
+		    {
+			keep(std::snprintf(buf, sizeof(buf), "%.2f",
+			    v[i & 1023]));
+		    });
+
+#if defined(__cpp_lib_to_chars)
+		run("std::to_chars fixed, 2", n, [&](long i)
+		    {
+			keep(std::to_chars(buf, buf + sizeof(buf),
+			    v[i & 1023], std::chars_format::fixed, 2));
+		    });
+#endif
+
+		stdex::formatter<double> f2(stdex::string_view(".2f"));
+
+		run("formatter<double> .2f", n, [&](long i)
+		    {
+			s.clear();
+			f2.output(stdex::format_writer<std::string>(s),
+			    v[i & 1023]);
+			keep(s);
+		    });
+
+		run("vsformat {:.2f}", n, [&](long i)
+		    {
+			s.clear();
+			stdex::detail::vsformat(s,
+			    stdex::string_view("{:.2f}"),
+			    std::forward_as_tuple(v[i & 1023]));
+			keep(s);
+		    });
+	}
+}
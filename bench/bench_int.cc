@@ -0,0 +1,113 @@
+#include "../format.h"
+
+#include "bench.h"
+
+#include <vector>
+#include <random>
+#include <cstdio>
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+int main()
+{
+	std::mt19937_64 g(42);
+	std::vector<long long> small, large;
+
+	for (int i = 0; i < 1024; ++i)
+	{
+		small.push_back(int(g() % 2000) - 1000);
+		large.push_back((long long)g() >> (g() % 64));
+	}
+
+	long const n = 1 << 22;
+	std::string s;
+	char buf[48];
+
+	for (auto vp : { &small, &large })
+	{
+		auto& v = *vp;
+
+		std::printf("-- %s\n", vp == &small ? "small" : "large");
+
+		run("snprintf %lld", n, [&](long i)
+		    {
+			keep(std::snprintf(buf, sizeof(buf), "%lld",
+			    v[i & 1023]));
+		    });
+
+#if defined(__cpp_lib_to_chars)
+		run("std::to_chars", n, [&](long i)
+		    {
+			keep(std::to_chars(buf, buf + sizeof(buf),
+			    v[i & 1023]));
+		    });
+#endif
+
+		run("vsformat {}", n, [&](long i)
+		    {
+			s.clear();
+			stdex::detail::vsformat(s, stdex::string_view("{}"),
+			    std::forward_as_tuple(v[i & 1023]));
+			keep(s);
+		    });
+
+		run("vsformat {:>24}", n, [&](long i)
+		    {
+			s.clear();
+			stdex::detail::vsformat(s,
+			    stdex::string_view("{:>24}"),
+			    std::forward_as_tuple(v[i & 1023]));
+			keep(s);
+		    });
+
+		run("snprintf %llx", n, [&](long i)
+		    {
+			keep(std::snprintf(buf, sizeof(buf), "%llx",
+			    (unsigned long long)v[i & 1023]));
+		    });
+
+		run("vsformat {:x}", n, [&](long i)
+		    {
+			auto u = (unsigned long long)v[i & 1023];
+
+			s.clear();
+			stdex::detail::vsformat(s, stdex::string_view("{:x}"),
+			    std::forward_as_tuple(u));
+			keep(s);
+		    });
+
+		run("format {}", n, [&](long i)
+		    {
+			keep(stdex::format("{}", v[i & 1023]));
+		    });
+	}
+#if defined(__SIZEOF_INT128__)
+	std::vector<unsigned __int128> wide;
+
+	for (int i = 0; i < 1024; ++i)
+		wide.push_back((unsigned __int128)g() << 64 | g());
+
+	std::printf("-- 128-bit\n");
+
+	run("digit loop", n, [&](long i)
+	    {
+		auto u = wide[i & 1023];
+		char* p = buf + sizeof(buf);
+
+		do
+			*--p = char('0' + u % 10);
+		while (u /= 10);
+
+		keep(p);
+	    });
+
+	run("vsformat {}", n, [&](long i)
+	    {
+		s.clear();
+		stdex::detail::vsformat(s, stdex::string_view("{}"),
+		    std::forward_as_tuple(wide[i & 1023]));
+		keep(s);
+	    });
+#endif
+}
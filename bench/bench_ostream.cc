@@ -0,0 +1,27 @@
+#include "../ostream_format.h"
+
+#include "bench.h"
+
+#include <fstream>
+#include <string>
+
+int main()
+{
+	long const n = 1 << 20;
+	std::ofstream out("/dev/null");
+	auto log = stdex::make_formatted(out);
+	std::string path = "/api/v1/items/1234?page=7";
+
+	run("ofstream log line", n, [&](long i)
+	    {
+		log("{} GET {} {} {:>8} bytes\n", i, path,
+		    200 + (i & 3), i * 17);
+	    });
+
+	std::string body(300, 'x');
+
+	run("ofstream long line", n, [&](long i)
+	    {
+		log("{} {} {}\n", i, body, body);
+	    });
+}
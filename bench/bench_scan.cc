@@ -0,0 +1,44 @@
+#include "../format.h"
+
+#include "bench.h"
+
+#include <string>
+
+int main()
+{
+	long const n = 1 << 20;
+	std::string text(400, 'x');
+	std::string fmt = text + "{}" + text + "{:>8}" + text + "{}";
+	stdex::string_view v = fmt;
+
+	run("find_first_of \"{}\"", n, [&](long i)
+	    {
+		keep(v.substr(i & 63).find_first_of("{}"));
+	    });
+
+	run("find_brace", n, [&](long i)
+	    {
+		auto s = v.substr(i & 63);
+		keep(stdex::detail::find_brace(s.data(), s.size()));
+	    });
+
+	run("scan_swar", n, [&](long i)
+	    {
+		char const braces[] = { '{', '}' };
+		auto s = v.substr(i & 63);
+		keep(stdex::detail::scan_swar<true, 2>(s.data(), 0, s.size(),
+		    braces));
+	    });
+
+	std::string s;
+
+	run("vsformat long template", n, [&](long i)
+	    {
+		int code = int(i & 7);
+
+		s.clear();
+		stdex::detail::vsformat(s, v,
+		    std::forward_as_tuple(i, code, i));
+		keep(s);
+	    });
+}
@@ -0,0 +1,74 @@
+#include "../format.h"
+
+#include "bench.h"
+
+#include <string>
+#include <cstdio>
+
+// a user type whose formatter does not report its width
+struct cell
+{
+	long v;
+};
+
+template <>
+struct stdex::formatter<cell>
+{
+	template <typename Writer>
+	void output(Writer w, cell c)
+	{
+		w.send(stdex::string_view("#"));
+		stdex::formatter<long>().output(w, c.v);
+	}
+};
+
+int main()
+{
+	long const n = 1 << 18;
+	std::string payload(600, 'x');
+	char const* fmt = "{{\"id\":{},\"user\":\"{}\",\"score\":{:.3f},"
+	    "\"tags\":\"{}\",\"note\":\"{}\",\"body\":\"{}\",\"seq\":{}}}";
+
+	run("format record", n, [&](long i)
+	    {
+		keep(stdex::format(fmt, i, "someone", i * 0.5, payload,
+		    payload, payload, i));
+	    });
+
+	run("format exact_size record", n, [&](long i)
+	    {
+		keep(stdex::format(stdex::exact_size, fmt, i, "someone",
+		    i * 0.5, payload, payload, payload, i));
+	    });
+
+	run("formatted_size record", n, [&](long i)
+	    {
+		keep(stdex::formatted_size(fmt, i, "someone", i * 0.5,
+		    payload, payload, payload, i));
+	    });
+
+	char buf[256];
+
+	run("snprintf short line", n, [&](long i)
+	    {
+		keep(std::snprintf(buf, sizeof(buf), "%8ld|%s|%d", i,
+		    "someone", int(i & 7)));
+	    });
+
+	run("format_to_n short line", n, [&](long i)
+	    {
+		keep(stdex::format_to_n(buf, sizeof(buf), "{:>8}|{}|{}", i,
+		    "someone", int(i & 7)));
+	    });
+
+	run("format short line", n, [&](long i)
+	    {
+		keep(stdex::format("{:>8}|{}|{}", i, "someone", int(i & 7)));
+	    });
+
+	run("format right-aligned user cells", n, [&](long i)
+	    {
+		keep(stdex::format("{:>12}|{:>12}|{:>12}", cell{ i },
+		    cell{ i * 7 }, cell{ -i }));
+	    });
+}
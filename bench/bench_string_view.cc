@@ -0,0 +1,91 @@
+#include "../string_view.h"
+
+#include "bench.h"
+
+#include <string>
+
+int main()
+{
+	long const n = 1 << 20;
+	std::string req = "GET /index.html HTTP/1.1\r\n";
+
+	for (int i = 0; i < 12; ++i)
+		req += "X-Header-" + std::to_string(i) +
+		    ": some moderately long value, with a comma\r\n";
+
+	req += "\r\n";
+
+	std::u16string wide(req.begin(), req.end());
+	stdex::string_view v = req;
+	stdex::u16string_view w = wide;
+
+	run("find char", n, [&](long i)
+	    {
+		keep(v.substr(i & 63).find('\n', 500));
+	    });
+
+	run("find char16_t", n, [&](long i)
+	    {
+		keep(w.substr(i & 63).find(u'\n', 500));
+	    });
+
+	run("find \"\\r\\n\\r\\n\"", n, [&](long i)
+	    {
+		keep(v.substr(i & 63).find("\r\n\r\n"));
+	    });
+
+	run("find u\"\\r\\n\\r\\n\"", n, [&](long i)
+	    {
+		keep(w.substr(i & 63).find(u"\r\n\r\n"));
+	    });
+
+	run("find_first_of \":\\r\\n\"", n, [&](long i)
+	    {
+		keep(v.substr(i & 63).find_first_of(":\r\n", 500));
+	    });
+
+	run("find_first_of \";\\r\\n\\t\"", n, [&](long i)
+	    {
+		keep(v.substr(i & 63).find_first_of(";\r\n\t", 500));
+	    });
+
+	run("find_first_of 10 chars", n, [&](long i)
+	    {
+		keep(v.substr(i & 63).find_first_of("\r\n\t\f\v;#|<>"));
+	    });
+
+	run("find_first_not_of token chars", n, [&](long i)
+	    {
+		keep(v.substr(i & 63).find_first_not_of(
+		    "abcdefghijklmnopqrstuvwxyz"
+		    "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-/. :,"));
+	    });
+
+	std::string key = "Content-Length";
+	std::hash<std::string> string_hash;
+	std::hash<stdex::string_view> view_hash;
+
+	run("std::hash<std::string> 14 chars", n, [&](long i)
+	    {
+		key[0] = char(i);
+		keep(string_hash(key));
+	    });
+
+	run("std::hash<string_view> 14 chars", n, [&](long i)
+	    {
+		key[0] = char(i);
+		keep(view_hash(key));
+	    });
+
+	run("std::hash<std::string> header block", n, [&](long i)
+	    {
+		req[0] = char(i);
+		keep(string_hash(req));
+	    });
+
+	run("std::hash<string_view> header block", n, [&](long i)
+	    {
+		req[0] = char(i);
+		keep(view_hash(req));
+	    });
+}
@@ -0,0 +1,771 @@
+/*-
+ * Copyright (c) 2013 Zhihao Yuan.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _STDEX_BINARY_LOG_H
+#define _STDEX_BINARY_LOG_H
+
+#include "format.h"
+
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+#include <deque>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+// Deferred logging: binary_log_writer records the id of the format
+// string and the raw bytes of the arguments instead of the text, and
+// binary_log_reader turns the records back into the text, later and
+// elsewhere, by running them through the same formatting code.
+//
+// The stream, version 1 (all multi-byte fixed-width fields are
+// little-endian; "varint" is LEB128, unsigned):
+//
+//   header      "STDXBLOG", u16 version, u16 flags (0)
+//   record      u8 tag, then
+//     tag 1     defines a format: varint id, varint length, the chars;
+//               ids count from 0, and a definition precedes every use
+//     tag 2     an event: varint id, varint argc, then argc arguments,
+//               each a u8 type code and a payload
+//
+//   type code                      payload
+//    1 bool                        u8, 0 or 1
+//    2 char                        u8
+//    3 signed char                 zigzag varint
+//    4 short                       zigzag varint
+//    5 int                         zigzag varint
+//    6 long                        zigzag varint
+//    7 long long                   zigzag varint
+//    8 unsigned char               varint
+//    9 unsigned short              varint
+//   10 unsigned int                varint
+//   11 unsigned long               varint
+//   12 unsigned long long          varint
+//   13 float                       the 4 bytes of the IEEE single
+//   14 double                      the 8 bytes of the IEEE double
+//   15 string                      varint length, the chars
+//   16 pointer                     varint, the address
+//
+// The type code names the C++ type the argument had, so the reader
+// hands the formatter<T> of the writer the same value; the integer
+// types are read at the widths of the reader's platform.  Strings are
+// those formatted by formatter<basic_string_view<char>> and friends;
+// other types, long double included, do not compile.  Format errors
+// surface on decoding.
+
+namespace stdex {
+
+enum class binary_log_type : unsigned char
+{
+	boolean = 1,
+	char_,
+	signed_char,
+	short_,
+	int_,
+	long_,
+	long_long,
+	unsigned_char,
+	unsigned_short,
+	unsigned_int,
+	unsigned_long,
+	unsigned_long_long,
+	float_,
+	double_,
+	string,
+	pointer,
+};
+
+namespace detail {
+
+enum : unsigned char
+{
+	blog_define = 1,
+	blog_event = 2,
+};
+
+constexpr char blog_magic[] = "STDXBLOG";
+constexpr unsigned blog_version = 1;
+
+template <binary_log_type C>
+using blog_code = std::integral_constant<binary_log_type, C>;
+
+// the type code of an argument of type T, after decay
+template <typename T>
+struct binary_log_code {};
+
+template <>
+struct binary_log_code<bool> : blog_code<binary_log_type::boolean> {};
+
+template <>
+struct binary_log_code<char> : blog_code<binary_log_type::char_> {};
+
+template <>
+struct binary_log_code<signed char>
+	: blog_code<binary_log_type::signed_char> {};
+
+template <>
+struct binary_log_code<short> : blog_code<binary_log_type::short_> {};
+
+template <>
+struct binary_log_code<int> : blog_code<binary_log_type::int_> {};
+
+template <>
+struct binary_log_code<long> : blog_code<binary_log_type::long_> {};
+
+template <>
+struct binary_log_code<long long>
+	: blog_code<binary_log_type::long_long> {};
+
+template <>
+struct binary_log_code<unsigned char>
+	: blog_code<binary_log_type::unsigned_char> {};
+
+template <>
+struct binary_log_code<unsigned short>
+	: blog_code<binary_log_type::unsigned_short> {};
+
+template <>
+struct binary_log_code<unsigned int>
+	: blog_code<binary_log_type::unsigned_int> {};
+
+template <>
+struct binary_log_code<unsigned long>
+	: blog_code<binary_log_type::unsigned_long> {};
+
+template <>
+struct binary_log_code<unsigned long long>
+	: blog_code<binary_log_type::unsigned_long_long> {};
+
+template <>
+struct binary_log_code<float> : blog_code<binary_log_type::float_> {};
+
+template <>
+struct binary_log_code<double> : blog_code<binary_log_type::double_> {};
+
+template <typename Traits>
+struct binary_log_code<basic_string_view<char, Traits>>
+	: blog_code<binary_log_type::string> {};
+
+template <typename Traits, typename Allocator>
+struct binary_log_code<std::basic_string<char, Traits, Allocator>>
+	: blog_code<binary_log_type::string> {};
+
+template <>
+struct binary_log_code<char const*> : blog_code<binary_log_type::string> {};
+
+template <>
+struct binary_log_code<char*> : blog_code<binary_log_type::string> {};
+
+// only a pointer written as its address; a string of another character
+// type, or a pointer with a formatter<T*> of its own, has no code
+template <typename T, typename = void>
+struct binary_log_pointer_code {};
+
+template <typename T>
+struct binary_log_pointer_code<T, If_t<formats_address<T>>>
+	: blog_code<binary_log_type::pointer> {};
+
+template <typename T>
+struct binary_log_code<T*> : binary_log_pointer_code<T> {};
+
+template <typename T, typename = void>
+struct has_binary_log_code : std::false_type {};
+
+template <typename T>
+struct has_binary_log_code<T, void_t<typename binary_log_code<T>::type>>
+	: std::true_type {};
+
+inline
+void blog_put_varint(std::string& s, std::uint64_t v)
+{
+	while (v >= 0x80)
+	{
+		s.push_back(char(v | 0x80));
+		v >>= 7;
+	}
+
+	s.push_back(char(v));
+}
+
+template <typename UInt>
+inline
+void blog_put_fixed(std::string& s, UInt v)
+{
+	for (std::size_t i = 0; i < sizeof(UInt); ++i, v = UInt(v >> 8))
+		s.push_back(char(v & 0xff));
+}
+
+inline
+void blog_put_chars(std::string& s, char const* p, std::size_t n)
+{
+	blog_put_varint(s, n);
+	s.append(p, n);
+}
+
+template <typename T>
+inline
+void blog_put_value(std::string& s, T v, blog_code<binary_log_type::boolean>)
+{
+	s.push_back(char(v));
+}
+
+template <typename T>
+inline
+void blog_put_value(std::string& s, T v, blog_code<binary_log_type::char_>)
+{
+	s.push_back(v);
+}
+
+template <typename T, binary_log_type C>
+inline
+auto blog_put_value(std::string& s, T v, blog_code<C>)
+	-> If_t<std::is_integral<T>>
+{
+	// zigzag: the sign goes to the lowest bit
+	if (std::is_signed<T>::value)
+		blog_put_varint(s, v < 0 ? ~(std::uint64_t(v) << 1) :
+		    std::uint64_t(v) << 1);
+	else
+		blog_put_varint(s, std::uint64_t(v));
+}
+
+inline
+void blog_put_value(std::string& s, float v, blog_code<binary_log_type::float_>)
+{
+	std::uint32_t u;
+	std::memcpy(&u, &v, sizeof(u));
+	blog_put_fixed(s, u);
+}
+
+inline
+void blog_put_value(std::string& s, double v,
+    blog_code<binary_log_type::double_>)
+{
+	std::uint64_t u;
+	std::memcpy(&u, &v, sizeof(u));
+	blog_put_fixed(s, u);
+}
+
+template <typename Traits>
+inline
+void blog_put_value(std::string& s, basic_string_view<char, Traits> v,
+    blog_code<binary_log_type::string>)
+{
+	blog_put_chars(s, v.data(), v.size());
+}
+
+template <typename Traits, typename Allocator>
+inline
+void blog_put_value(std::string& s,
+    std::basic_string<char, Traits, Allocator> const& v,
+    blog_code<binary_log_type::string>)
+{
+	blog_put_chars(s, v.data(), v.size());
+}
+
+inline
+void blog_put_value(std::string& s, char const* v,
+    blog_code<binary_log_type::string>)
+{
+	blog_put_chars(s, v, std::char_traits<char>::length(v));
+}
+
+template <typename T>
+inline
+void blog_put_value(std::string& s, T* v,
+    blog_code<binary_log_type::pointer>)
+{
+	// as formatter<T*> takes it, function pointers included
+	blog_put_varint(s, reinterpret_cast<std::uintptr_t>(v));
+}
+
+// an argument read back; strings are offsets into the chars of the
+// event, which may move while it is read
+struct binary_value
+{
+	binary_log_type type;
+	std::uint64_t bits;
+	std::size_t size;
+};
+
+// the arguments of an event, standing in for the tuple of the original
+// call; see write_arg_at and arg_as_int_at below
+struct binary_log_args
+{
+	binary_value const* args;
+	std::size_t size;
+	char const* chars;
+};
+
+template <typename T>
+inline
+T blog_float(std::uint64_t bits)
+{
+	using U = std::conditional_t<sizeof(T) == 4, std::uint32_t,
+	    std::uint64_t>;
+
+	U u = U(bits);
+	T v;
+	std::memcpy(&v, &u, sizeof(v));
+
+	return v;
+}
+
+// calls f with the value of the argument v as the type it had when
+// written, followed by o...
+template <typename F, typename... Opts>
+inline
+auto replay_value(binary_value const& v, char const* chars, F f,
+    Opts... o)
+	-> decltype(f(0, o...))
+{
+	auto i = std::int64_t(v.bits);
+
+	switch (v.type)
+	{
+	case binary_log_type::boolean:
+		return f(bool(v.bits), o...);
+	case binary_log_type::char_:
+		return f(char(v.bits), o...);
+	case binary_log_type::signed_char:
+		return f((signed char)(i), o...);
+	case binary_log_type::short_:
+		return f(short(i), o...);
+	case binary_log_type::int_:
+		return f(int(i), o...);
+	case binary_log_type::long_:
+		return f(long(i), o...);
+	case binary_log_type::long_long:
+		return f((long long)(i), o...);
+	case binary_log_type::unsigned_char:
+		return f((unsigned char)(v.bits), o...);
+	case binary_log_type::unsigned_short:
+		return f((unsigned short)(v.bits), o...);
+	case binary_log_type::unsigned_int:
+		return f((unsigned int)(v.bits), o...);
+	case binary_log_type::unsigned_long:
+		return f((unsigned long)(v.bits), o...);
+	case binary_log_type::unsigned_long_long:
+		return f((unsigned long long)(v.bits), o...);
+	case binary_log_type::float_:
+		return f(blog_float<float>(v.bits), o...);
+	case binary_log_type::double_:
+		return f(blog_float<double>(v.bits), o...);
+	case binary_log_type::string:
+		return f(string_view(chars + v.bits, v.size), o...);
+	case binary_log_type::pointer:
+		return f(reinterpret_cast<void const*>(
+		    std::uintptr_t(v.bits)), o...);
+	}
+
+	throw std::invalid_argument
+	{
+	    "unknown type code in binary log"
+	};
+}
+
+struct replay_write
+{
+	template <typename T, typename Writer, typename... Opts>
+	void operator()(T const& v, Writer w, Opts... o)
+	{
+		write_arg_at(1, std::forward_as_tuple(v), w, o...);
+	}
+};
+
+struct replay_int
+{
+	template <typename T>
+	int operator()(T const& v)
+	{
+		return arg_as_int_at(1, std::forward_as_tuple(v));
+	}
+};
+
+inline
+binary_value const& blog_arg_at(int n, binary_log_args tp)
+{
+	if (n < 1 or std::size_t(n) > tp.size)
+		throw std::out_of_range
+		{
+		    "tuple index out of range"
+		};
+
+	return tp.args[n - 1];
+}
+
+// formats the n-th argument of an event as a tuple of that argument
+// alone would be formatted; found by vsformat through ADL
+template <typename Writer, typename... Opts>
+inline
+void write_arg_at(int n, binary_log_args tp, Writer w, Opts... o)
+{
+	replay_value(blog_arg_at(n, tp), tp.chars, replay_write(), w, o...);
+}
+
+inline
+int arg_as_int_at(int n, binary_log_args tp)
+{
+	return replay_value(blog_arg_at(n, tp), tp.chars, replay_int());
+}
+
+}
+
+// Writes the records of calls to a stream; the records are buffered,
+// and go out by pages, on flush(), and on destruction.  Not thread-safe.
+struct binary_log_writer
+{
+	explicit binary_log_writer(std::ostream& out) : out_(out)
+	{
+		buf_.append(detail::blog_magic, 8);
+		detail::blog_put_fixed(buf_, std::uint16_t(detail::blog_version));
+		detail::blog_put_fixed(buf_, std::uint16_t(0));
+	}
+
+	binary_log_writer(binary_log_writer const&) = delete;
+	binary_log_writer& operator=(binary_log_writer const&) = delete;
+
+	~binary_log_writer()
+	{
+		try
+		{
+			flush();
+		}
+		catch (...)
+		{}
+	}
+
+	template <typename... T>
+	bool operator()(string_view fmt, T const&... t)
+	{
+		auto id = format_id(fmt);
+
+		buf_.push_back(char(detail::blog_event));
+		detail::blog_put_varint(buf_, id);
+		detail::blog_put_varint(buf_, sizeof...(T));
+
+		int _[] = { 0, (put_arg(t), 0)... };
+		(void)_;
+
+		if (buf_.size() >= page_size)
+			write_out();
+
+		return out_.good();
+	}
+
+	bool flush()
+	{
+		write_out();
+		out_.flush();
+
+		return out_.good();
+	}
+
+private:
+	static constexpr std::size_t page_size = 4096;
+
+	template <typename T>
+	void put_arg(T const& v)
+	{
+		using U = std::decay_t<T>;
+
+		static_assert(detail::has_binary_log_code<U>::value,
+		    "argument type has no binary log encoding");
+
+		using code = detail::binary_log_code<U>;
+
+		buf_.push_back(char(code::value));
+		detail::blog_put_value(buf_, v, code());
+	}
+
+	std::size_t format_id(string_view fmt)
+	{
+		auto it = ids_.find(fmt);
+
+		if (it != ids_.end())
+			return it->second;
+
+		formats_.emplace_back(fmt.data(), fmt.size());
+
+		auto id = ids_.size();
+		auto& s = formats_.back();
+		ids_.emplace(string_view(s.data(), s.size()), id);
+
+		buf_.push_back(char(detail::blog_define));
+		detail::blog_put_varint(buf_, id);
+		detail::blog_put_chars(buf_, s.data(), s.size());
+
+		return id;
+	}
+
+	void write_out()
+	{
+		if (not buf_.empty() and out_.good())
+			out_.write(buf_.data(), std::streamsize(buf_.size()));
+
+		buf_.clear();
+	}
+
+	std::ostream& out_;
+	std::string buf_;
+	std::deque<std::string> formats_;	// keys of ids_ point in here
+	std::unordered_map<string_view, std::size_t> ids_;
+};
+
+// Reads the records written by a binary_log_writer and formats the
+// events one by one.  Throws std::invalid_argument on a stream which
+// is not a binary log, is of a later version, or ends within a record.
+struct binary_log_reader
+{
+	explicit binary_log_reader(std::istream& in) : sb_(in.rdbuf())
+	{
+		char magic[8];
+
+		if (sb_ == nullptr or sb_->sgetn(magic, 8) != 8 or
+		    std::memcmp(magic, detail::blog_magic, 8) != 0)
+			throw std::invalid_argument
+			{
+			    "not a binary log"
+			};
+
+		version_ = unsigned(get_fixed(2));
+		get_fixed(2);
+
+		if (version_ == 0 or version_ > detail::blog_version)
+			throw std::invalid_argument
+			{
+			    "unsupported binary log version"
+			};
+	}
+
+	unsigned version() const
+	{
+		return version_;
+	}
+
+	// replaces the content of s with the next event formatted;
+	// false at the end of the stream
+	bool next(std::string& s)
+	{
+		using traits = std::char_traits<char>;
+
+		while (1)
+		{
+			auto tag = sb_->sbumpc();
+
+			if (traits::eq_int_type(tag, traits::eof()))
+				return false;
+
+			switch (tag)
+			{
+			case detail::blog_define:
+				read_define();
+				break;
+			case detail::blog_event:
+				read_event();
+				s.clear();
+				detail::vsformat(s, format_at(id_),
+				    detail::binary_log_args
+				    {
+					args_.data(), args_.size(),
+					chars_.data()
+				    });
+				return true;
+			default:
+				throw std::invalid_argument
+				{
+				    "unknown binary log record"
+				};
+			}
+		}
+	}
+
+private:
+	[[noreturn]] static void truncated()
+	{
+		throw std::invalid_argument
+		{
+		    "truncated binary log record"
+		};
+	}
+
+	unsigned char get_byte()
+	{
+		auto c = sb_->sbumpc();
+
+		if (std::char_traits<char>::eq_int_type(c,
+		    std::char_traits<char>::eof()))
+			truncated();
+
+		return (unsigned char)(c);
+	}
+
+	std::uint64_t get_fixed(int n)
+	{
+		std::uint64_t v = 0;
+
+		for (int i = 0; i < n; ++i)
+			v |= std::uint64_t(get_byte()) << (8 * i);
+
+		return v;
+	}
+
+	std::uint64_t get_varint()
+	{
+		std::uint64_t v = 0;
+
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			auto c = get_byte();
+			v |= std::uint64_t(c & 0x7f) << shift;
+
+			if (c < 0x80)
+				return v;
+		}
+
+		throw std::invalid_argument
+		{
+		    "varint too long in binary log"
+		};
+	}
+
+	// appends n chars of the stream to s; n is read from the stream
+	// too, so s grows a chunk at a time, only as far as there is data
+	void get_chars(std::string& s, std::size_t n)
+	{
+		std::size_t const chunk = 65536;
+
+		while (n != 0)
+		{
+			auto k = std::min(n, chunk);
+			auto old = s.size();
+
+			s.resize(old + k);
+
+			if (sb_->sgetn(&s[old], std::streamsize(k)) !=
+			    std::streamsize(k))
+				truncated();
+
+			n -= k;
+		}
+	}
+
+	void read_define()
+	{
+		auto id = get_varint();
+
+		if (id != formats_.size())
+			throw std::invalid_argument
+			{
+			    "format ids out of order in binary log"
+			};
+
+		formats_.emplace_back();
+		get_chars(formats_.back(), std::size_t(get_varint()));
+	}
+
+	void read_event()
+	{
+		id_ = std::size_t(get_varint());
+		auto argc = get_varint();
+
+		format_at(id_);
+		args_.clear();
+		chars_.clear();
+
+		for (; argc != 0; --argc)
+		{
+			detail::binary_value v = {};
+			v.type = binary_log_type(get_byte());
+
+			switch (v.type)
+			{
+			case binary_log_type::boolean:
+			case binary_log_type::char_:
+				v.bits = get_byte();
+				break;
+			case binary_log_type::signed_char:
+			case binary_log_type::short_:
+			case binary_log_type::int_:
+			case binary_log_type::long_:
+			case binary_log_type::long_long:
+			{
+				auto u = get_varint();
+				v.bits = (u & 1) ? ~(u >> 1) : u >> 1;
+				break;
+			}
+			case binary_log_type::unsigned_char:
+			case binary_log_type::unsigned_short:
+			case binary_log_type::unsigned_int:
+			case binary_log_type::unsigned_long:
+			case binary_log_type::unsigned_long_long:
+			case binary_log_type::pointer:
+				v.bits = get_varint();
+				break;
+			case binary_log_type::float_:
+				v.bits = get_fixed(4);
+				break;
+			case binary_log_type::double_:
+				v.bits = get_fixed(8);
+				break;
+			case binary_log_type::string:
+				v.size = std::size_t(get_varint());
+				v.bits = chars_.size();
+				get_chars(chars_, v.size);
+				break;
+			default:
+				throw std::invalid_argument
+				{
+				    "unknown type code in binary log"
+				};
+			}
+
+			args_.push_back(v);
+		}
+	}
+
+	string_view format_at(std::size_t id) const
+	{
+		if (id >= formats_.size())
+			throw std::invalid_argument
+			{
+			    "undefined format id in binary log"
+			};
+
+		return { formats_[id].data(), formats_[id].size() };
+	}
+
+	std::streambuf* sb_;
+	unsigned version_;
+	std::size_t id_;
+	std::vector<std::string> formats_;
+	std::vector<detail::binary_value> args_;
+	std::string chars_;
+};
+
+}
+
+#endif
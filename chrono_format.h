@@ -0,0 +1,749 @@
+/*-
+ * Copyright (c) 2013 Zhihao Yuan.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _STDEX_CHRONO_FORMAT_H
+#define _STDEX_CHRONO_FORMAT_H
+
+#include "format.h"
+
+#include <chrono>
+#include <ratio>
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace stdex {
+
+namespace detail {
+
+#define _G(c) _STDEX_G(CharT, c)
+
+struct civil_date
+{
+	std::int64_t	year;
+	unsigned	month;
+	unsigned	day;
+};
+
+// floor(a / b), b > 0
+inline
+std::int64_t floor_div(std::int64_t a, std::int64_t b)
+{
+	return a / b - (a % b < 0);
+}
+
+// days since 1970-01-01 to the proleptic Gregorian calendar and back,
+// after Howard Hinnant's civil_from_days and days_from_civil
+inline
+civil_date civil_from_days(std::int64_t z)
+{
+	z += 719468;
+
+	auto era = floor_div(z, 146097);
+	auto doe = unsigned(z - era * 146097);
+	auto yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	auto doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	auto mp = (5 * doy + 2) / 153;
+	unsigned d = doy - (153 * mp + 2) / 5 + 1;
+	unsigned m = mp < 10 ? mp + 3 : mp - 9;
+
+	return { std::int64_t(yoe) + era * 400 + (m <= 2), m, d };
+}
+
+inline
+std::int64_t days_from_civil(std::int64_t y, unsigned m, unsigned d)
+{
+	y -= m <= 2;
+
+	auto era = floor_div(y, 400);
+	auto yoe = unsigned(y - era * 400);
+	auto doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	auto doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+	return era * 146097 + std::int64_t(doe) - 719468;
+}
+
+// the decimal places of a tick of Period, up to nanoseconds
+template <typename Period>
+constexpr int subsecond_digits()
+{
+	int k = 0;
+
+	for (std::intmax_t p = 1; k < 9 and p * Period::num % Period::den;
+	    p *= 10)
+		++k;
+
+	return k;
+}
+
+template <typename CharT>
+inline
+bool is_time_conversion(CharT ch)
+{
+	switch (ch)
+	{
+	case _G('a'): case _G('A'): case _G('b'): case _G('B'):
+	case _G('d'): case _G('D'): case _G('e'): case _G('f'):
+	case _G('F'): case _G('h'): case _G('H'): case _G('I'):
+	case _G('j'): case _G('m'): case _G('M'): case _G('n'):
+	case _G('p'): case _G('R'): case _G('s'): case _G('S'):
+	case _G('t'): case _G('T'): case _G('u'): case _G('w'):
+	case _G('y'): case _G('Y'): case _G('z'): case _G('Z'):
+	case _G('%'):
+		return true;
+	default:
+		return false;
+	}
+}
+
+template <typename CharT>
+inline
+void check_time_pattern(basic_string_view<CharT> s)
+{
+	for (; not s.empty(); s.remove_prefix(1))
+	{
+		if (s.front() != _G('%'))
+			continue;
+
+		s.remove_prefix(1);
+
+		if (s.size() >= 2 and _G('0') < s[0] and s[0] <= _G('9') and
+		    s[1] == _G('f'))
+			s.remove_prefix(1);
+
+		else if (not s.empty() and is_time_conversion(s.front()))
+			continue;
+
+		else
+			throw std::invalid_argument
+			{
+			    "time format specifier should be a strftime "
+			    "pattern of \"aAbBdDefFhHIjmMnpRsStTuwyYzZ%\""
+			};
+	}
+}
+
+enum class duration_unit : char
+{
+	native, ns, us, ms, s, min, h, automatic,
+};
+
+template <typename CharT>
+inline
+duration_unit parse_duration_unit(basic_string_view<CharT> s)
+{
+	if (s.empty())
+		return duration_unit::native;
+	if (s == _G("ns"))
+		return duration_unit::ns;
+	if (s == _G("us"))
+		return duration_unit::us;
+	if (s == _G("ms"))
+		return duration_unit::ms;
+	if (s == _G("s"))
+		return duration_unit::s;
+	if (s == _G("min"))
+		return duration_unit::min;
+	if (s == _G("h"))
+		return duration_unit::h;
+	if (s == _G("auto"))
+		return duration_unit::automatic;
+
+	throw std::invalid_argument
+	{
+	    R"(duration format specifier should be )"
+	    R"("[.precision][ns|us|ms|s|min|h|auto]")"
+	};
+}
+
+// the unit symbol of a duration, with "[num/den]s" for a period
+// without one
+template <typename Period, typename CharT>
+inline
+basic_string_view<CharT> unit_suffix(CharT* buf)
+{
+	constexpr std::uint64_t num = Period::num;
+	constexpr std::uint64_t den = Period::den;
+
+	if (num == 1 and den == 1000000000)
+		return _G("ns");
+	if (num == 1 and den == 1000000)
+		return _G("us");
+	if (num == 1 and den == 1000)
+		return _G("ms");
+	if (num == 1 and den == 1)
+		return _G("s");
+	if (num == 60 and den == 1)
+		return _G("min");
+	if (num == 3600 and den == 1)
+		return _G("h");
+	if (num == 86400 and den == 1)
+		return _G("d");
+
+	auto p = buf;
+
+	*p++ = _G('[');
+	p = write_digits(p, count_digits(num), num);
+
+	if (den != 1)
+	{
+		*p++ = _G('/');
+		p = write_digits(p, count_digits(den), den);
+	}
+
+	*p++ = _G(']');
+	*p++ = _G('s');
+
+	return { buf, std::size_t(p - buf) };
+}
+
+// u ticks of Period in Unit, as an integral part q and a remainder r
+// over den; resolved at compile time except for the divisions.
+template <typename Period, typename Unit>
+struct unit_conversion
+{
+	using ratio = std::ratio_divide<Period, Unit>;
+
+	static constexpr std::uint64_t num = ratio::num;
+	static constexpr std::uint64_t den = ratio::den;
+
+	static_assert(den <= std::uint64_t(-1) / num,
+	    "the ratio between the units is too large");
+
+	// false on overflow
+	static bool apply(std::uint64_t u, std::uint64_t& q, std::uint64_t& r)
+	{
+		auto q1 = u / den;
+		auto t = u % den * num;
+
+		if (num != 1 and q1 > (std::uint64_t(-1) - t / den) / num)
+			return false;
+
+		q = q1 * num + t / den;
+		r = t % den;
+
+		return true;
+	}
+
+	// the decimal places of 1 / den, or 9 if they do not terminate
+	static constexpr int places()
+	{
+		int k = 0;
+
+		for (std::uint64_t p = 1; k < 19 and p % den; p *= 10)
+			++k;
+
+		return k < 19 ? k : 9;
+	}
+};
+
+// a writer whose content is followed by n more characters
+template <typename Writer>
+struct suffixed_writer
+{
+	using char_type = typename Writer::char_type;
+	using traits_type = typename Writer::traits_type;
+	using size_type = typename Writer::size_type;
+
+	suffixed_writer(Writer w, int n) :
+		w_(w), n_(n)
+	{}
+
+	template <typename... Args>
+	void send(Args&&... args)
+	{
+		w_.send(std::forward<Args>(args)...);
+	}
+
+	char_type* extend(size_type n)
+	{
+		return w_.extend(n);
+	}
+
+	void content_width_will_be(int w)
+	{
+		w_.content_width_will_be(w + n_);
+	}
+
+private:
+	Writer	w_;
+	int	n_;
+};
+
+// u ticks of Period in Unit, rounded half to even to precision places;
+// without a precision, the places needed for the exact value, or 9
+// for a fraction that does not terminate, but no trailing zeros.
+template <typename Unit, typename Period, typename Writer>
+void write_duration(Writer w, bool neg, std::uint64_t u, int precision,
+    basic_string_view<typename Writer::char_type> suffix)
+{
+	using conversion = unit_conversion<Period, Unit>;
+
+	std::uint64_t q, r, f = 0;
+
+	if (not conversion::apply(u, q, r))
+		throw std::overflow_error
+		{
+		    "duration overflows the unit in format"
+		};
+
+	int p = precision < 0 ? (r ? conversion::places() : 0) : precision;
+
+	for (int i = 0; i < p; ++i)
+	{
+		r *= 10;
+		f = f * 10 + r / conversion::den;
+		r %= conversion::den;
+	}
+
+	auto rest = conversion::den - r;
+
+	if (r > rest or (r == rest and (p ? f : q) % 2))
+	{
+		if (++f == power_of_10(p))
+		{
+			f = 0;
+			++q;
+		}
+	}
+
+	if (precision < 0)
+		for (; p and f % 10 == 0; --p)
+			f /= 10;
+
+	char buf[40];
+	int n = count_digits(q);
+
+	write_digits(buf, n, q);
+
+	if (p)
+		write_digits_padded(buf + n, p, f);
+
+	write_fixed(suffixed_writer<Writer>(w, int(suffix.size())), neg,
+	    string_digits(buf, n + p, n + p), p, 0);
+	w.send(suffix);
+}
+
+// A pattern rendered for one second, where the sub-second fields are
+// left as zeros to be filled for each time point.
+template <typename CharT>
+struct time_cache
+{
+	using string_type = std::basic_string<CharT>;
+
+	bool matches(basic_string_view<CharT> pattern, std::int64_t s) const
+	{
+		return valid and second == s and
+		    pattern.size() == this->pattern.size() and
+		    std::equal(pattern.begin(), pattern.end(),
+			this->pattern.begin());
+	}
+
+	void render(basic_string_view<CharT> pattern, std::int64_t s,
+	    int digits)
+	{
+		valid = false;
+		check_time_pattern(pattern);
+		this->pattern.assign(pattern.data(), pattern.size());
+		second = s;
+		text.clear();
+		subseconds.clear();
+
+		auto days = floor_div(s, 86400);
+		auto secs = unsigned(s - days * 86400);
+
+		date_ = civil_from_days(days);
+		yday_ = unsigned(days - days_from_civil(date_.year, 1, 1));
+		wday_ = unsigned(floor_div(days + 4, 7) * -7 + days + 4);
+		hour_ = secs / 3600;
+		minute_ = secs / 60 % 60;
+		second_ = secs % 60;
+
+		for (auto it = pattern.begin(); it != pattern.end(); ++it)
+		{
+			if (*it != _G('%'))
+			{
+				text.push_back(*it);
+				continue;
+			}
+
+			if (*++it == _G('f'))
+				put_subseconds(digits);
+
+			else if (_G('0') < *it and *it <= _G('9'))
+				put_subseconds(int(*it++ - _G('0')));
+
+			else
+				put(*it);
+		}
+
+		valid = true;
+	}
+
+	string_type pattern;
+	string_type text;
+	std::vector<std::pair<std::size_t, int>> subseconds;
+	std::int64_t second = 0;
+	bool valid = false;
+
+private:
+	void put(CharT ch)
+	{
+		static char const* const days[] =
+		{
+		    "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday",
+		    "Friday", "Saturday",
+		};
+		static char const* const months[] =
+		{
+		    "January", "February", "March", "April", "May", "June",
+		    "July", "August", "September", "October", "November",
+		    "December",
+		};
+
+		switch (ch)
+		{
+		case _G('a'):
+			return put_ascii(days[wday_], 3);
+		case _G('A'):
+			return put_ascii(days[wday_]);
+		case _G('b'):
+		case _G('h'):
+			return put_ascii(months[date_.month - 1], 3);
+		case _G('B'):
+			return put_ascii(months[date_.month - 1]);
+		case _G('d'):
+			return put_digits(date_.day, 2);
+		case _G('D'):
+			put(_G('m'));
+			text.push_back(_G('/'));
+			put(_G('d'));
+			text.push_back(_G('/'));
+			return put(_G('y'));
+		case _G('e'):
+			if (date_.day < 10)
+				text.push_back(_G(' '));
+			return put_digits(date_.day, date_.day < 10 ? 1 : 2);
+		case _G('F'):
+			put(_G('Y'));
+			text.push_back(_G('-'));
+			put(_G('m'));
+			text.push_back(_G('-'));
+			return put(_G('d'));
+		case _G('H'):
+			return put_digits(hour_, 2);
+		case _G('I'):
+			return put_digits((hour_ + 11) % 12 + 1, 2);
+		case _G('j'):
+			return put_digits(yday_ + 1, 3);
+		case _G('m'):
+			return put_digits(date_.month, 2);
+		case _G('M'):
+			return put_digits(minute_, 2);
+		case _G('n'):
+			return text.push_back(_G('\n'));
+		case _G('p'):
+			return put_ascii(hour_ < 12 ? "AM" : "PM");
+		case _G('R'):
+			put(_G('H'));
+			text.push_back(_G(':'));
+			return put(_G('M'));
+		case _G('s'):
+			return put_integer(second);
+		case _G('S'):
+			return put_digits(second_, 2);
+		case _G('t'):
+			return text.push_back(_G('\t'));
+		case _G('T'):
+			put(_G('R'));
+			text.push_back(_G(':'));
+			return put(_G('S'));
+		case _G('u'):
+			return put_digits(wday_ ? wday_ : 7, 1);
+		case _G('w'):
+			return put_digits(wday_, 1);
+		case _G('y'):
+			return put_digits(unsigned(date_.year -
+			    floor_div(date_.year, 100) * 100), 2);
+		case _G('Y'):
+			if (0 <= date_.year and date_.year < 1000)
+				return put_digits(unsigned(date_.year), 4);
+			return put_integer(date_.year);
+		case _G('z'):
+			return put_ascii("+0000");
+		case _G('Z'):
+			return put_ascii("UTC");
+		default:
+			return text.push_back(ch);
+		}
+	}
+
+	void put_ascii(char const* s, std::size_t n = std::size_t(-1))
+	{
+		for (; n and *s; --n)
+			text.push_back(CharT(*s++));
+	}
+
+	void put_digits(std::uint64_t v, int n)
+	{
+		text.append(n, _G('0'));
+		write_digits_padded(&text[text.size() - n], n, v);
+	}
+
+	void put_integer(std::int64_t v)
+	{
+		if (v < 0)
+			text.push_back(_G('-'));
+
+		auto u = v < 0 ? 0 - std::uint64_t(v) : std::uint64_t(v);
+
+		put_digits(u, count_digits(u));
+	}
+
+	void put_subseconds(int n)
+	{
+		if (n == 0)
+			return;
+
+		subseconds.emplace_back(text.size(), n);
+		text.append(n, _G('0'));
+	}
+
+	civil_date	date_;
+	unsigned	yday_;
+	unsigned	wday_;
+	unsigned	hour_;
+	unsigned	minute_;
+	unsigned	second_;
+};
+
+#undef _G
+
+}
+
+#define _G(c) _STDEX_G(CharT, c)
+
+// A strftime-like pattern in UTC, such as "%Y-%m-%dT%H:%M:%S.%fZ", where
+// "%f" is the fraction of the second in the precision of the time point
+// and "%3f" to "%9f" cut it at that many digits.  Each thread caches the
+// rendering of the last pattern for the last second, so that a time
+// point in the same second only writes the fraction.  The default
+// pattern is "%F %T", followed by ".%f" for a time point finer than
+// seconds.  The pattern is checked only when it misses the cache, so
+// that a formatter constructed for every record costs nothing.
+template <typename Duration>
+struct formatter<std::chrono::time_point<std::chrono::system_clock, Duration>>
+{
+	using time_point =
+	    std::chrono::time_point<std::chrono::system_clock, Duration>;
+
+	typedef void reports_width;
+
+	formatter() = default;
+
+	// the pattern is checked when it is rendered
+	template <typename CharT>
+	explicit formatter(basic_string_view<CharT> spec) :
+		pattern_(spec.data()), size_(spec.size())
+	{}
+
+	template <typename Writer>
+	void output(Writer w, time_point tp)
+	{
+		using CharT = typename Writer::char_type;
+		using namespace std::chrono;
+
+		static thread_local detail::time_cache<CharT> cache;
+
+		constexpr int digits =
+		    detail::subsecond_digits<typename Duration::period>();
+
+		basic_string_view<CharT> pattern = digits ?
+		    _G("%F %T.%f") : _G("%F %T");
+
+		// the format string outlives the formatter
+		if (pattern_)
+			pattern = basic_string_view<CharT>(
+			    static_cast<CharT const*>(pattern_), size_);
+
+		auto d = tp.time_since_epoch();
+		auto s = duration_cast<seconds>(d);
+
+		if (s > d)
+			s -= seconds(1);
+
+		if (not cache.matches(pattern, s.count()))
+			cache.render(pattern, s.count(), digits);
+
+		auto ns = std::uint64_t(duration_cast<nanoseconds>(d - s).count());
+		auto n = cache.text.size();
+
+		w.content_width_will_be(n);
+
+		auto p = w.extend(n);
+
+		std::copy_n(cache.text.data(), n, p);
+
+		for (auto& f : cache.subseconds)
+			detail::write_digits_padded(p + f.first, f.second,
+			    ns / detail::power_of_10(9 - f.second));
+	}
+
+private:
+	void const*	pattern_ = nullptr;	// CharT const*
+	std::size_t	size_ = 0;
+};
+
+// [.precision][unit], where unit is one of "ns", "us", "ms", "s", "min"
+// and "h", or "auto" for the largest of "ns" to "s" which the duration
+// reaches.  The count is converted with the ratio of the periods, and
+// rounded half to even to the precision; without a precision, an
+// integral count shows the exact value, in up to 9 decimal places for a
+// fraction that does not terminate, and a floating-point count its
+// shortest form.  The default is the count in the period of the
+// duration, such as "42ms" or "5[1/3]s".
+template <typename Rep, typename Period>
+struct formatter<std::chrono::duration<Rep, Period>>
+{
+	using duration = std::chrono::duration<Rep, Period>;
+
+	typedef void reports_width;
+
+	formatter() = default;
+
+	template <typename CharT>
+	explicit formatter(basic_string_view<CharT> spec)
+	{
+		if (not spec.empty() and spec.front() == _G('.'))
+		{
+			spec.remove_prefix(1);
+			precision_ = detail::parse_precision(spec);
+
+			if (precision_ > 18)
+				throw std::invalid_argument
+				{
+				    "duration precision should not exceed 18"
+				};
+		}
+
+		unit_ = detail::parse_duration_unit(spec);
+	}
+
+	template <typename Writer>
+	void output(Writer w, duration d)
+	{
+		using CharT = typename Writer::char_type;
+		using detail::duration_unit;
+
+		CharT buf[48];
+
+		switch (unit_)
+		{
+		case duration_unit::ns:
+			return output_in<std::nano>(w, d, _G("ns"));
+		case duration_unit::us:
+			return output_in<std::micro>(w, d, _G("us"));
+		case duration_unit::ms:
+			return output_in<std::milli>(w, d, _G("ms"));
+		case duration_unit::s:
+			return output_in<std::ratio<1>>(w, d, _G("s"));
+		case duration_unit::min:
+			return output_in<std::ratio<60>>(w, d, _G("min"));
+		case duration_unit::h:
+			return output_in<std::ratio<3600>>(w, d, _G("h"));
+		case duration_unit::automatic:
+			break;
+		default:
+			return output_in<Period>(w, d,
+			    detail::unit_suffix<Period>(buf));
+		}
+
+		using std::chrono::duration_cast;
+		using seconds = std::chrono::duration<long double>;
+
+		auto x = duration_cast<seconds>(d).count();
+
+		if (x < 0)
+			x = -x;
+
+		if (x >= 1)
+			return output_in<std::ratio<1>>(w, d, _G("s"));
+		if (x >= 1e-3L)
+			return output_in<std::milli>(w, d, _G("ms"));
+		if (x >= 1e-6L)
+			return output_in<std::micro>(w, d, _G("us"));
+
+		output_in<std::nano>(w, d, _G("ns"));
+	}
+
+private:
+	template <typename Writer>
+	using suffix_type = basic_string_view<typename Writer::char_type>;
+
+	template <typename Unit, typename Writer>
+	void output_in(Writer w, duration d, suffix_type<Writer> suffix)
+	{
+		output_in<Unit>(w, d, suffix, std::is_floating_point<Rep>());
+	}
+
+	template <typename Unit, typename Writer>
+	void output_in(Writer w, duration d, suffix_type<Writer> suffix,
+	    std::false_type)
+	{
+		auto c = d.count();
+		bool neg = c < Rep(0);
+
+		detail::write_duration<Unit, Period>(w, neg,
+		    neg ? 0 - std::uint64_t(c) : std::uint64_t(c),
+		    precision_, suffix);
+	}
+
+	template <typename Unit, typename Writer>
+	void output_in(Writer w, duration d, suffix_type<Writer> suffix,
+	    std::true_type)
+	{
+		using real_type = std::conditional_t
+		    <
+			std::is_same<Rep, long double>::value,
+			long double,
+			double
+		    >;
+
+		auto v = std::chrono::duration<real_type, Unit>(d).count();
+
+		detail::float_formatter<real_type>(precision_).output(
+		    detail::suffixed_writer<Writer>(w, int(suffix.size())), v);
+		w.send(suffix);
+	}
+
+	int precision_ = -1;
+	detail::duration_unit unit_ = detail::duration_unit::native;
+};
+
+#undef _G
+
+}
+
+#endif
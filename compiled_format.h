@@ -0,0 +1,682 @@
+/*-
+ * Copyright (c) 2013 Zhihao Yuan.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _STDEX_COMPILED_FORMAT_H
+#define _STDEX_COMPILED_FORMAT_H
+
+#include "format.h"
+
+#include <memory>
+#include <vector>
+#include <utility>
+
+namespace stdex {
+
+// A format string parsed once for the argument types T..., with the
+// formatters of its fields constructed from their specs.  render()
+// replays the literal text and the fields against the arguments.  The
+// object keeps a copy of the format string, so that the formatters may
+// refer to their specs.
+template <typename CharT, typename... T>
+struct basic_compiled_format
+{
+	using char_type = CharT;
+
+	explicit basic_compiled_format(basic_string_view<CharT> fmt) :
+		fmt_(new CharT[fmt.size()])
+	{
+		std::copy(fmt.begin(), fmt.end(), fmt_.get());
+		compiler c = { *this };
+		detail::parse_format(basic_string_view<CharT>(fmt_.get(),
+		    fmt.size()), c);
+	}
+
+	// appends to a sink; see sink_traits
+	template <typename Sink>
+	void render(Sink& buf, T const&... args) const
+	{
+		auto fields = field_renderers<Sink>(
+		    std::index_sequence_for<T...>());
+		args_type tp(args...);
+
+		for (auto& o : ops_)
+		{
+			if (o.arg == 0)
+				sink_traits<Sink>::append(buf,
+				    fmt_.get() + o.offset, o.size);
+			else
+				fields[o.arg](*this, o, buf, tp);
+		}
+	}
+
+	std::basic_string<CharT> render(T const&... args) const
+	{
+		std::basic_string<CharT> buf;
+
+		render(buf, args...);
+
+		return buf;
+	}
+
+private:
+	using args_type = std::tuple<T const&...>;
+
+	// a literal span of fmt_ if arg is 0, a field otherwise
+	struct op
+	{
+		std::size_t		offset;
+		std::size_t		size;
+		int			arg;
+		int			width;
+		int			width_arg;
+		int			slot;
+		detail::adjustment	adj;
+		bool			justified;
+	};
+
+	struct compiler
+	{
+		void on_literal(CharT const* s, std::size_t n)
+		{
+			if (n == 0)
+				return;
+
+			std::size_t offset = s - self.fmt_.get();
+			auto& ops = self.ops_;
+
+			if (not ops.empty() and ops.back().arg == 0 and
+			    ops.back().offset + ops.back().size == offset)
+				ops.back().size += n;
+			else
+				ops.push_back({ offset, n, 0, 0, 0, 0,
+				    detail::adjustment::unspecified, false });
+		}
+
+		void on_field(detail::field_spec<CharT> const& f)
+		{
+			if (f.arg > int(sizeof...(T)) or
+			    f.width_arg > int(sizeof...(T)))
+				throw std::out_of_range
+				{
+				    "tuple index out of range"
+				};
+
+			int slot = add_formatter(f.arg, self, f.spec,
+			    std::index_sequence_for<T...>());
+
+			self.ops_.push_back({ 0, 0, f.arg, f.width, f.width_arg,
+			    slot, f.adj, f.justified });
+		}
+
+		basic_compiled_format& self;
+	};
+
+	template <std::size_t I>
+	using arg_t = std::decay_t<std::tuple_element_t<I, std::tuple<T...>>>;
+
+	template <std::size_t I>
+	static int add_formatter(basic_compiled_format& self,
+	    basic_string_view<CharT> spec)
+	{
+		auto& v = std::get<I>(self.formatters_);
+
+		if (spec.empty())
+			v.emplace_back();
+		else
+			emplace_formatter(v, spec, std::is_constructible
+			    <
+				formatter<arg_t<I>>,
+				basic_string_view<CharT>
+			    >());
+
+		return int(v.size() - 1);
+	}
+
+	template <typename Vector>
+	static void emplace_formatter(Vector& v, basic_string_view<CharT> spec,
+	    std::true_type)
+	{
+		v.emplace_back(spec);
+	}
+
+	template <typename Vector>
+	static void emplace_formatter(Vector&, basic_string_view<CharT>,
+	    std::false_type)
+	{
+		throw std::invalid_argument
+		{
+		    "target type accepts no format specifier"
+		};
+	}
+
+	template <std::size_t... I>
+	static int add_formatter(int n, basic_compiled_format& self,
+	    basic_string_view<CharT> spec, std::index_sequence<I...>)
+	{
+		using fn = int (*)(basic_compiled_format&,
+		    basic_string_view<CharT>);
+
+		static constexpr fn table[] = { nullptr, &add_formatter<I>... };
+
+		return table[n](self, spec);
+	}
+
+	template <typename Sink, std::size_t I>
+	static void render_field(basic_compiled_format const& self,
+	    op const& o, Sink& buf, args_type const& tp)
+	{
+		auto f = std::get<I>(self.formatters_)[o.slot];
+
+		if (not o.justified)
+			return f.output(detail::writer_access::make(buf),
+			    std::get<I>(tp));
+
+		int width = o.width;
+
+		if (o.width_arg)
+			width = std::max(detail::arg_as_int_at(o.width_arg, tp),
+			    0);
+
+		auto w = detail::writer_access::make(buf, width);
+
+		detail::output_justified<arg_t<I>>(w, o.adj, f, std::get<I>(tp));
+	}
+
+	template <typename Sink>
+	using render_fn = void (*)(basic_compiled_format const&, op const&,
+	    Sink&, args_type const&);
+
+	template <typename Sink, std::size_t... I>
+	static auto field_renderers(std::index_sequence<I...>)
+		-> render_fn<Sink> const*
+	{
+		static constexpr render_fn<Sink> table[] =
+		{
+		    nullptr, &render_field<Sink, I>...
+		};
+
+		return table;
+	}
+
+	std::unique_ptr<CharT[]> fmt_;
+	std::vector<op> ops_;
+	std::tuple<std::vector<formatter<std::decay_t<T>>>...> formatters_;
+};
+
+template <typename... T>
+using compiled_format = basic_compiled_format<char, T...>;
+
+template <typename... T>
+using wcompiled_format = basic_compiled_format<wchar_t, T...>;
+
+template <typename... T>
+using u16compiled_format = basic_compiled_format<char16_t, T...>;
+
+template <typename... T>
+using u32compiled_format = basic_compiled_format<char32_t, T...>;
+
+// A format string known at compile time, as made by the _fmt literal.
+// format() parses it during compilation and checks the replacement
+// fields against the argument types; what is left to run time is a
+// sequence of appends and formatter calls.
+template <typename CharT, CharT... cs>
+struct basic_format_string
+{
+	using char_type = CharT;
+
+	static constexpr CharT data[] = { cs..., CharT() };
+
+	static constexpr std::size_t size()
+	{
+		return sizeof...(cs);
+	}
+
+	constexpr operator basic_string_view<CharT>() const
+	{
+		return { data, size() };
+	}
+};
+
+template <typename CharT, CharT... cs>
+constexpr CharT basic_format_string<CharT, cs...>::data[];
+
+namespace detail {
+
+#define _G(c) _STDEX_G(CharT, c)
+
+enum class ct_error
+{
+	none,
+	single_open,
+	single_close,
+	unmatched_open,
+	expecting_colon,
+	expecting_digit,
+	switch_to_manual,
+	switch_to_automatic,
+	overflow,
+};
+
+// one step of parse_format, evaluated during compilation; the indices
+// count from 1
+struct ct_piece
+{
+	enum { end, literal, field, error } kind;
+	ct_error err;
+	std::size_t first;	// the literal text, or the spec of a field
+	std::size_t last;
+	std::size_t next;
+	int arg;
+	int width;
+	int width_arg;
+	adjustment adj;
+	bool justified;
+	bool sequential;
+};
+
+template <typename CharT>
+constexpr
+bool ct_leads_digits(CharT ch)
+{
+	return _G('0') < ch and ch <= _G('9');
+}
+
+template <typename CharT>
+constexpr
+int ct_parse_int(CharT const* s, std::size_t n, std::size_t& i, bool& ovf)
+{
+	int v = 0;
+
+	for (; i < n and (_G('0') <= s[i] and s[i] <= _G('9')); ++i)
+	{
+		int d = s[i] - _G('0');
+
+		if ((std::numeric_limits<int>::max() - d) / 10 < v)
+			ovf = true;
+		else
+			v = v * 10 + d;
+	}
+
+	return v;
+}
+
+constexpr
+ct_piece ct_fail(ct_piece p, ct_error e)
+{
+	p.kind = ct_piece::error;
+	p.err = e;
+
+	return p;
+}
+
+template <typename CharT>
+constexpr
+ct_piece ct_parse_piece(CharT const* s, std::size_t n, std::size_t i,
+    int arg_index, bool sequential)
+{
+	ct_piece p = {};
+
+	p.arg = arg_index;
+	p.sequential = sequential;
+
+	if (i == n)
+	{
+		p.kind = ct_piece::end;
+		return p;
+	}
+
+	std::size_t j = i;
+
+	while (j < n and s[j] != _G('{') and s[j] != _G('}'))
+		++j;
+
+	// a doubled brace ends the literal text in front of it
+	bool escape = j + 1 < n and s[j + 1] == s[j];
+
+	if (j == n or escape)
+	{
+		p.kind = ct_piece::literal;
+		p.first = i;
+		p.last = j == n ? n : j + 1;
+		p.next = j == n ? n : j + 2;
+		return p;
+	}
+
+	if (j != i)
+	{
+		p.kind = ct_piece::literal;
+		p.first = i;
+		p.last = j;
+		p.next = j;
+		return p;
+	}
+
+	if (s[i] == _G('}'))
+		return ct_fail(p, ct_error::single_close);
+
+	if (++i == n)
+		return ct_fail(p, ct_error::single_open);
+
+	bool ovf = false;
+
+	if (ct_leads_digits(s[i]))
+	{
+		if (arg_index == 0)
+			p.sequential = false;
+		else if (p.sequential)
+			return ct_fail(p, ct_error::switch_to_manual);
+
+		p.arg = ct_parse_int(s, n, i, ovf);
+	}
+	else
+	{
+		if (arg_index == 0)
+			p.sequential = true;
+		else if (not p.sequential)
+			return ct_fail(p, ct_error::switch_to_automatic);
+
+		++p.arg;
+	}
+
+	if (i == n)
+		return ct_fail(p, ct_error::unmatched_open);
+
+	if (s[i] == _G('}'))
+	{
+		p.kind = ct_piece::field;
+		p.next = i + 1;
+		return ovf ? ct_fail(p, ct_error::overflow) : p;
+	}
+
+	if (s[i++] != _G(':'))
+		return ct_fail(p, ct_error::expecting_colon);
+
+	if (i == n)
+		return ct_fail(p, ct_error::unmatched_open);
+
+	p.justified = true;
+
+	if (s[i] == _G('<'))
+		p.adj = adjustment::left;
+	else if (s[i] == _G('>'))
+		p.adj = adjustment::right;
+
+	if (p.adj != adjustment::unspecified and ++i == n)
+		return ct_fail(p, ct_error::unmatched_open);
+
+	if (ct_leads_digits(s[i]))
+	{
+		p.width = ct_parse_int(s, n, i, ovf);
+	}
+	else if (s[i] == _G('*'))
+	{
+		++i;
+
+		if (p.sequential)
+			p.width_arg = p.arg++;
+		else if (i == n or not ct_leads_digits(s[i]))
+			return ct_fail(p, ct_error::expecting_digit);
+		else
+			p.width_arg = ct_parse_int(s, n, i, ovf);
+	}
+
+	p.first = i;
+
+	while (i < n and s[i] != _G('}'))
+		++i;
+
+	if (i == n)
+		return ct_fail(p, ct_error::unmatched_open);
+
+	p.kind = ct_piece::field;
+	p.last = i;
+	p.next = i + 1;
+
+	return ovf ? ct_fail(p, ct_error::overflow) : p;
+}
+
+#undef _G
+
+template <typename Str>
+constexpr
+ct_piece ct_next(std::size_t i, int arg_index, bool sequential)
+{
+	return ct_parse_piece(Str::data, Str::size(), i, arg_index,
+	    sequential);
+}
+
+template <typename Str, std::size_t I, int Arg, bool Seq,
+          int Kind = ct_next<Str>(I, Arg, Seq).kind>
+struct ct_format;
+
+template <typename Str, std::size_t I, int Arg, bool Seq>
+struct ct_format<Str, I, Arg, Seq, ct_piece::end>
+{
+	template <typename Sink, typename Tuple>
+	static
+	void apply(Sink&, Tuple const&)
+	{}
+};
+
+template <typename Str, std::size_t I, int Arg, bool Seq>
+struct ct_format<Str, I, Arg, Seq, ct_piece::literal>
+{
+	static constexpr ct_piece p = ct_next<Str>(I, Arg, Seq);
+
+	template <typename Sink, typename Tuple>
+	static
+	void apply(Sink& buf, Tuple const& tp)
+	{
+		sink_traits<Sink>::append(buf, Str::data + p.first,
+		    p.last - p.first);
+		ct_format<Str, p.next, p.arg, p.sequential>::apply(buf, tp);
+	}
+};
+
+template <typename Str, std::size_t I, int Arg, bool Seq>
+struct ct_format<Str, I, Arg, Seq, ct_piece::error>
+{
+	static constexpr ct_error e = ct_next<Str>(I, Arg, Seq).err;
+
+	static_assert(e != ct_error::single_open,
+	    "Single '{' encountered in format string");
+	static_assert(e != ct_error::single_close,
+	    "Single '}' encountered in format string");
+	static_assert(e != ct_error::unmatched_open,
+	    "unmatched '{' in format");
+	static_assert(e != ct_error::expecting_colon,
+	    "expecting ':' or '}'");
+	static_assert(e != ct_error::expecting_digit,
+	    "expecting a nonzero digit");
+	static_assert(e != ct_error::switch_to_manual,
+	    "cannot switch from automatic field numbering to manual "
+	    "field specification");
+	static_assert(e != ct_error::switch_to_automatic,
+	    "cannot switch from manual field specification to automatic "
+	    "field numbering");
+	static_assert(e != ct_error::overflow,
+	    "integer overflow in format");
+
+	template <typename Sink, typename Tuple>
+	static
+	void apply(Sink&, Tuple const&)
+	{}
+};
+
+template <typename Str, std::size_t I, int Arg, bool Seq>
+struct ct_format<Str, I, Arg, Seq, ct_piece::field>
+{
+	static constexpr ct_piece p = ct_next<Str>(I, Arg, Seq);
+
+	template <typename Sink, typename Tuple>
+	static
+	void apply(Sink& buf, Tuple const& tp)
+	{
+		constexpr int n = std::tuple_size<Tuple>::value;
+
+		static_assert(p.arg <= n and p.width_arg <= n,
+		    "tuple index out of range");
+
+		field(buf, tp, bool_constant<(p.arg <= n and
+		    p.width_arg <= n)>());
+		ct_format<Str, p.next, p.arg, p.sequential>::apply(buf, tp);
+	}
+
+private:
+	using char_type = typename Str::char_type;
+
+	template <typename T>
+	using accepts_spec = std::is_constructible
+	    <
+		formatter<T>, basic_string_view<char_type>
+	    >;
+
+	template <typename Sink, typename Tuple>
+	static
+	void field(Sink&, Tuple const&, std::false_type)
+	{}
+
+	template <typename Sink, typename Tuple>
+	static
+	void field(Sink& buf, Tuple const& tp, std::true_type)
+	{
+		using T = std::decay_t<std::tuple_element_t<p.arg - 1, Tuple>>;
+
+		static_assert(p.first == p.last or accepts_spec<T>(),
+		    "target type accepts no format specifier");
+
+		if (not p.justified)
+			return formatter<T>().output(
+			    writer_access::make(buf), std::get<p.arg - 1>(tp));
+
+		auto w = writer_access::make(buf, width(tp,
+		    bool_constant<(p.width_arg != 0)>()));
+
+		output<T>(w, std::get<p.arg - 1>(tp),
+		    bool_constant<(p.first != p.last)>());
+	}
+
+	template <typename Tuple>
+	static
+	int width(Tuple const&, std::false_type)
+	{
+		return p.width;
+	}
+
+	template <typename Tuple>
+	static
+	int width(Tuple const& tp, std::true_type)
+	{
+		using T = std::decay_t
+		    <
+			std::tuple_element_t<p.width_arg - 1, Tuple>
+		    >;
+
+		static_assert(is_nonarrow_convertible<T, int>() or
+		    std::is_integral<T>(), "target type cannot be used as int");
+
+		return std::max(arg_as_int_at_impl<p.width_arg>::apply(tp), 0);
+	}
+
+	template <typename T, typename Writer, typename U>
+	static
+	void output(Writer& w, U const& v, std::false_type)
+	{
+		formatter<T> f;
+
+		output_justified<T>(w, p.adj, f, v);
+	}
+
+	// the formatter is built from its spec once; each call works on
+	// a copy, for output() is not const
+	template <typename T, typename Writer, typename U>
+	static
+	void output(Writer& w, U const& v, std::true_type)
+	{
+		static formatter<T> const fmt(basic_string_view<char_type>(
+		    Str::data + p.first, p.last - p.first));
+		formatter<T> f(fmt);
+
+		output_justified<T>(w, p.adj, f, v);
+	}
+};
+
+template <typename Str, std::size_t I, int Arg, bool Seq>
+constexpr ct_piece ct_format<Str, I, Arg, Seq, ct_piece::literal>::p;
+
+template <typename Str, std::size_t I, int Arg, bool Seq>
+constexpr ct_piece ct_format<Str, I, Arg, Seq, ct_piece::field>::p;
+
+template <typename Sink, typename CharT, CharT... cs, typename Tuple>
+inline
+void vsformat(Sink& buf, basic_format_string<CharT, cs...>, Tuple tp)
+{
+	ct_format<basic_format_string<CharT, cs...>, 0, 0, false>
+	    ::apply(buf, tp);
+}
+
+}
+
+template <typename CharT, CharT... cs, typename... T>
+inline
+std::basic_string<CharT> format(basic_format_string<CharT, cs...> fmt,
+                                T const&... t)
+{
+	std::basic_string<CharT> buf;
+
+	buf.reserve(detail::pow2_roundup(fmt.size()));
+	detail::vsformat(buf, fmt, std::forward_as_tuple(t...));
+
+	return buf;
+}
+
+#if defined(__GNUC__)
+
+inline namespace literals {
+inline namespace format_literals {
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-string-literal-operator-template"
+#endif
+
+template <typename CharT, CharT... cs>
+constexpr basic_format_string<CharT, cs...> operator"" _fmt()
+{
+	return {};
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+
+}
+}
+
+#endif
+
+}
+
+#endif
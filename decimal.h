@@ -0,0 +1,222 @@
+/*-
+ * Copyright (c) 2013 Zhihao Yuan.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _STDEX_DECIMAL_H
+#define _STDEX_DECIMAL_H
+
+#include "format.h"
+
+#include <cstdint>
+
+namespace stdex {
+
+// An exact decimal number, mantissa * 10^-scale; decimal(12345, 2) is
+// 123.45.  A negative scale stands for trailing zeros.
+struct decimal
+{
+	constexpr decimal(std::int64_t mantissa, int scale = 0) noexcept :
+		mantissa_(mantissa), scale_(scale)
+	{}
+
+	constexpr std::int64_t mantissa() const noexcept
+	{
+		return mantissa_;
+	}
+
+	constexpr int scale() const noexcept
+	{
+		return scale_;
+	}
+
+private:
+	std::int64_t	mantissa_;
+	int		scale_;
+};
+
+// A decimal with the scale fixed at compile time, such as
+// fixed_decimal<2> for an amount in cents.
+template <int Scale>
+struct fixed_decimal
+{
+	constexpr explicit fixed_decimal(std::int64_t mantissa) noexcept :
+		mantissa_(mantissa)
+	{}
+
+	constexpr std::int64_t mantissa() const noexcept
+	{
+		return mantissa_;
+	}
+
+	static constexpr int scale() noexcept
+	{
+		return Scale;
+	}
+
+	constexpr operator decimal() const noexcept
+	{
+		return { mantissa_, Scale };
+	}
+
+private:
+	std::int64_t	mantissa_;
+};
+
+#define _G(c) _STDEX_G(CharT, c)
+
+// [,][.precision][mode], where mode is how the digits beyond the
+// precision are rounded:
+//   "e" half to even (the default)
+//   "a" half away from zero
+//   "z" toward zero
+//   "c" toward positive infinity
+//   "n" toward negative infinity
+// "f" is taken as it is for the floating-point types: the digits are
+// always fixed, and it rounds half to even.  Without a precision, all
+// the digits of the scale are printed.
+template <>
+struct formatter<decimal>
+{
+	typedef void reports_width;
+
+	formatter() = default;
+
+	template <typename CharT>
+	explicit formatter(basic_string_view<CharT> spec)
+	{
+		if (not spec.empty() and spec.front() == _G(','))
+		{
+			group_ = true;
+			spec.remove_prefix(1);
+		}
+
+		if (not spec.empty() and spec.front() == _G('.'))
+		{
+			spec.remove_prefix(1);
+			precision_ = detail::parse_precision(spec);
+		}
+
+		if (spec.size() == 1)
+		{
+			switch (spec.front())
+			{
+			case _G('e'):
+			case _G('a'):
+			case _G('z'):
+			case _G('c'):
+			case _G('n'):
+				mode_ = char(spec.front());
+				return;
+			case _G('f'):
+				return;
+			}
+		}
+		else if (spec.empty())
+			return;
+
+		throw std::invalid_argument
+		{
+		    R"(decimal format specifier should be )"
+		    R"("[,][.precision][eazcnf]")"
+		};
+	}
+
+	template <typename Writer>
+	void output(Writer w, decimal v)
+	{
+		auto m = v.mantissa();
+		bool neg = m < 0;
+		auto u = neg ? 0 - std::uint64_t(m) : std::uint64_t(m);
+		int scale = v.scale();
+		int frac = precision_ < 0 ? std::max(scale, 0) : precision_;
+
+		if (scale > frac)
+		{
+			u = round(u, neg, scale - frac);
+			scale = frac;
+		}
+
+		if (u == 0 or scale >= 0)
+			return detail::write_fixed(w, neg, detail::u64_digits(u),
+			    std::max(scale, 0), frac - std::max(scale, 0),
+			    group_);
+
+		char buf[20];
+		int n = detail::count_digits(u);
+
+		detail::write_digits(buf, n, u);
+		detail::write_fixed(w, neg,
+		    detail::string_digits(buf, n, n - scale), 0, frac, group_);
+	}
+
+private:
+	// u / 10^k, rounded
+	std::uint64_t round(std::uint64_t u, bool neg, int k) const
+	{
+		std::uint64_t q = 0, r = u, half = ~std::uint64_t(0);
+
+		// 10^20 / 2 exceeds any remainder
+		if (k < 20)
+		{
+			auto p = detail::power_of_10(k);
+
+			q = u / p;
+			r = u % p;
+			half = p / 2;
+		}
+
+		if (r == 0)
+			return q;
+
+		switch (mode_)
+		{
+		case 'a':
+			return q + (r >= half);
+		case 'z':
+			return q;
+		case 'c':
+			return q + not neg;
+		case 'n':
+			return q + neg;
+		default:
+			return q + (r > half or (r == half and q % 2));
+		}
+	}
+
+	int precision_ = -1;
+	char mode_ = 'e';
+	bool group_ = false;
+};
+
+template <int Scale>
+struct formatter<fixed_decimal<Scale>> : formatter<decimal>
+{
+	using formatter<decimal>::formatter;
+};
+
+#undef _G
+
+}
+
+#endif
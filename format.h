@@ -27,10 +27,12 @@
 #define _STDEX_FORMAT_H
 
 #include "__formatter.h"
+#include "__scan.h"
 #include "__aux.h"
 
 #include <tuple>
 #include <functional>
+#include <memory>
 
 namespace stdex {
 
@@ -71,6 +73,311 @@ int parse_int(basic_string_view<CharT>& s)
 	return n;
 }
 
+// storage for extend() on buffers which cannot give out their own;
+// allocates only for requests longer than a formatted 128-bit integer,
+// which among the built-in formatters only bigint_view makes; longer
+// fixed-notation fields are sent in pieces
+template <typename CharT>
+struct scratch_area
+{
+	CharT* get(std::size_t n)
+	{
+		if (n <= sizeof(small_) / sizeof(CharT))
+			return small_;
+
+		if (large_.size() < n)
+			large_.resize(n);
+
+		return &large_[0];
+	}
+
+private:
+	CharT small_[136];
+	std::basic_string<CharT> large_;
+};
+
+// Writes to a character array of a fixed capacity, dropping what does
+// not fit; size() is the length the output would have had.  The part
+// of an extend() request crossing the end is written to a scratch area
+// and copied in by the next operation, or by settle().
+template <typename CharT>
+struct truncating_buffer
+{
+	using value_type = CharT;
+	using traits_type = std::char_traits<CharT>;
+	using size_type = std::size_t;
+
+	truncating_buffer(CharT* p, size_type cap) noexcept :
+		p_(p), cap_(cap)
+	{}
+
+	size_type size() const noexcept
+	{
+		return size_;
+	}
+
+	// the number of characters stored
+	size_type stored() const noexcept
+	{
+		return std::min(size_, cap_);
+	}
+
+	void push_back(CharT ch)
+	{
+		settle();
+
+		if (size_ < cap_)
+			p_[size_] = ch;
+
+		++size_;
+	}
+
+	void append(size_type n, CharT ch)
+	{
+		settle();
+
+		if (size_ < cap_)
+			traits_type::assign(p_ + size_,
+			    std::min(n, cap_ - size_), ch);
+
+		size_ += n;
+	}
+
+	void append(CharT const* s, size_type n)
+	{
+		settle();
+
+		if (size_ < cap_)
+			traits_type::copy(p_ + size_, s,
+			    std::min(n, cap_ - size_));
+
+		size_ += n;
+	}
+
+	void insert(size_type pos, size_type n, CharT ch)
+	{
+		settle();
+
+		if (pos < cap_)
+		{
+			auto end = stored();
+
+			if (pos + n < cap_)
+				traits_type::move(p_ + pos + n, p_ + pos,
+				    std::min(end - pos, cap_ - pos - n));
+
+			traits_type::assign(p_ + pos,
+			    std::min(n, cap_ - pos), ch);
+		}
+
+		size_ += n;
+	}
+
+	CharT* extend(size_type n)
+	{
+		settle();
+
+		auto pos = size_;
+		size_ += n;
+
+		if (size_ <= cap_)
+			return p_ + pos;
+
+		if (pos < cap_)
+		{
+			pending_ = pos;
+			pending_size_ = cap_ - pos;
+		}
+
+		return pending_scratch_ = scratch_.get(n);
+	}
+
+	void settle()
+	{
+		if (pending_size_ != 0)
+		{
+			traits_type::copy(p_ + pending_, pending_scratch_,
+			    pending_size_);
+			pending_size_ = 0;
+		}
+	}
+
+private:
+	CharT* p_;
+	size_type cap_;
+	size_type size_ = 0;
+	size_type pending_ = 0;
+	size_type pending_size_ = 0;
+	CharT* pending_scratch_ = nullptr;
+	scratch_area<CharT> scratch_;
+};
+
+// A buffer which keeps count of the characters written to it instead of
+// storing them; extend() hands out a scratch area.
+template <typename CharT>
+struct counting_buffer
+{
+	using value_type = CharT;
+	using traits_type = std::char_traits<CharT>;
+	using size_type = std::size_t;
+
+	size_type size() const noexcept
+	{
+		return size_;
+	}
+
+	void push_back(CharT)
+	{
+		++size_;
+	}
+
+	void append(size_type n, CharT)
+	{
+		size_ += n;
+	}
+
+	void append(CharT const*, size_type n)
+	{
+		size_ += n;
+	}
+
+	void insert(size_type, size_type n, CharT)
+	{
+		size_ += n;
+	}
+
+	CharT* extend(size_type n)
+	{
+		size_ += n;
+
+		return scratch_.get(n);
+	}
+
+private:
+	size_type size_ = 0;
+	scratch_area<CharT> scratch_;
+};
+
+// A sink over contiguous storage which asks grow(b, n) for room for at
+// least n characters when it runs out; the one sink of vformat_args,
+// also used to stage the output of a formatter.
+template <typename CharT>
+struct erased_buffer
+{
+	using value_type = CharT;
+	using traits_type = std::char_traits<CharT>;
+	using size_type = std::size_t;
+
+	erased_buffer(erased_buffer const&) = delete;
+	erased_buffer& operator=(erased_buffer const&) = delete;
+
+	size_type size() const noexcept
+	{
+		return size_;
+	}
+
+	CharT const* data() const noexcept
+	{
+		return p_;
+	}
+
+	void push_back(CharT ch)
+	{
+		reserve_more(1);
+		p_[size_++] = ch;
+	}
+
+	void append(size_type n, CharT ch)
+	{
+		reserve_more(n);
+		traits_type::assign(p_ + size_, n, ch);
+		size_ += n;
+	}
+
+	void append(CharT const* s, size_type n)
+	{
+		reserve_more(n);
+		traits_type::copy(p_ + size_, s, n);
+		size_ += n;
+	}
+
+	void insert(size_type pos, size_type n, CharT ch)
+	{
+		reserve_more(n);
+		traits_type::move(p_ + pos + n, p_ + pos, size_ - pos);
+		traits_type::assign(p_ + pos, n, ch);
+		size_ += n;
+	}
+
+	CharT* extend(size_type n)
+	{
+		reserve_more(n);
+		size_ += n;
+
+		return p_ + size_ - n;
+	}
+
+protected:
+	using grow_fn = void (*)(erased_buffer&, size_type);
+
+	erased_buffer(CharT* p, size_type cap, grow_fn grow) noexcept :
+		p_(p), cap_(cap), grow_(grow)
+	{}
+
+	~erased_buffer() = default;
+
+	size_type capacity() const noexcept
+	{
+		return cap_;
+	}
+
+	// the first size() characters must have been moved to p
+	void reset(CharT* p, size_type cap) noexcept
+	{
+		p_ = p;
+		cap_ = cap;
+	}
+
+private:
+	void reserve_more(size_type n)
+	{
+		if (cap_ - size_ < n)
+			grow_(*this, size_ + n);
+	}
+
+	CharT* p_;
+	size_type size_ = 0;
+	size_type cap_;
+	grow_fn grow_;
+};
+
+// an erased_buffer on the stack, moving to the heap when it fills up
+template <typename CharT>
+struct memory_buffer : erased_buffer<CharT>
+{
+	memory_buffer() noexcept :
+		erased_buffer<CharT>(small_, sizeof(small_) / sizeof(CharT),
+		    &grow)
+	{}
+
+private:
+	using base = erased_buffer<CharT>;
+
+	static void grow(base& b, std::size_t n)
+	{
+		auto& m = static_cast<memory_buffer&>(b);
+		auto cap = std::max(n, 2 * m.capacity());
+		std::unique_ptr<CharT[]> p(new CharT[cap]);
+
+		std::char_traits<CharT>::copy(p.get(), m.data(), m.size());
+		m.reset(p.get(), cap);
+		m.large_ = std::move(p);
+	}
+
+	std::unique_ptr<CharT[]> large_;
+	CharT small_[256];
+};
+
 enum class adjustment
 {
 	unspecified,
@@ -78,65 +385,123 @@ enum class adjustment
 	right,
 };
 
-template <int Low, int High, int Mid = (Low + High) / 2, typename = void>
-struct write_arg_at_impl;
+template <typename T, typename Writer>
+inline
+void decide_justification(Writer& w, adjustment adj, ...)
+{
+	if (adj != adjustment::left)
+		writer_access::padding_left(w);
+}
 
-template <int Low, int High, int Mid>
-struct write_arg_at_impl<Low, High, Mid, If_ct<(Low > High)>>
+template <typename T, typename Writer>
+inline
+void decide_justification(Writer& w, adjustment adj,
+    typename formatter<T>::default_left_justified* = 0)
 {
-	template <typename Tuple, typename Writer, typename... Opts>
-	static
-	void apply(int n, Tuple tp, Writer w, Opts... o)
-	{
-		throw std::out_of_range
-		{
-		    "tuple index out of range"
-		};
-	}
-};
+	if (adj == adjustment::right)
+		writer_access::padding_left(w);
+}
+
+// whether a formatter calls content_width_will_be() before its output,
+// declared with a member typedef reports_width
+template <typename Formatter, typename = void>
+struct reports_width : std::false_type {};
+
+template <typename Formatter>
+struct reports_width<Formatter, void_t<typename Formatter::reports_width>>
+	: std::true_type {};
+
+template <typename Writer, typename CharT>
+inline
+void output_measured(Writer& w, CharT const* p, std::size_t n)
+{
+	using view_type = basic_string_view<CharT, typename Writer::traits_type>;
+
+	w.content_width_will_be(int(n));
+	w.send(view_type(p, n));
+}
+
+// The output of a formatter which does not report its width is formatted
+// aside first, so that the padding on its left goes in front of it
+// without moving it; on the stack, moving to the heap if it is long.
+template <typename Writer, typename Formatter, typename U>
+inline
+void output_staged(Writer& w, Formatter& f, U const& v)
+{
+	memory_buffer<typename Writer::char_type> st;
 
-template <int Mid>
-struct write_arg_at_impl<Mid, Mid, Mid, void>
+	f.output(writer_access::make(st), v);
+	output_measured(w, st.data(), st.size());
+}
+
+template <typename Writer, typename Formatter, typename U>
+inline
+void output_padded(Writer& w, Formatter& f, U const& v, std::true_type)
+{
+	f.output(w, v);
+}
+
+template <typename Writer, typename Formatter, typename U>
+inline
+void output_padded(Writer& w, Formatter& f, U const& v, std::false_type)
+{
+	if (writer_access::pads_left(w))
+		output_staged(w, f, v);
+	else
+		f.output(w, v);
+}
+
+// formats v with f into w, justified as adj asks or as T prefers
+template <typename T, typename Writer, typename Formatter, typename U>
+inline
+void output_justified(Writer& w, adjustment adj, Formatter& f, U const& v)
+{
+	decide_justification<T>(w, adj, 0);
+	output_padded(w, f, v, reports_width<Formatter>());
+	writer_access::justify_content(w);
+}
+
+// formats the I-th element of a tuple, counting from 1
+template <int I>
+struct write_arg_at_impl
 {
 	template <typename Tuple, typename Writer, typename... Opts>
 	static
-	void apply(int n, Tuple tp, Writer w, Opts... o)
+	void apply(Tuple const& tp, Writer w, Opts... o)
 	{
 		using T = std::decay_t
 		    <
-			typename std::tuple_element<Mid - 1, Tuple>::type
+			typename std::tuple_element<I - 1, Tuple>::type
 		    >;
 
-		if (n != Mid)
-			throw std::out_of_range
-			{
-			    "tuple index out of range"
-			};
-
-		do_format<Mid - 1, T>(w, tp, o...);
+		do_format<I - 1, T>(w, tp, o...);
 	}
 
 private:
 
-	template <int I, typename T, typename Writer, typename Tuple>
+	template <int J, typename T, typename Writer, typename Tuple>
 	static
-	void do_format(Writer w, Tuple tp)
+	void do_format(Writer w, Tuple const& tp)
 	{
-		formatter<T>().output(w, std::get<I>(tp));
+		formatter<T>().output(w, std::get<J>(tp));
 	}
 
-	template <int I, typename T, typename Writer, typename Tuple,
+	template <int J, typename T, typename Writer, typename Tuple,
 	          typename Spec>
 	static
-	void do_format_with_spec(Writer w, Tuple tp, Spec spec, std::true_type)
+	void do_format_with_spec(Writer w, Tuple const& tp, adjustment adj,
+	    Spec spec, std::true_type)
 	{
-		formatter<T>(spec).output(w, std::get<I>(tp));
+		formatter<T> f(spec);
+
+		output_justified<T>(w, adj, f, std::get<J>(tp));
 	}
 
-	template <int I, typename T, typename Writer, typename Tuple,
+	template <int J, typename T, typename Writer, typename Tuple,
 	          typename Spec>
 	static
-	void do_format_with_spec(Writer w, Tuple tp, Spec spec, std::false_type)
+	void do_format_with_spec(Writer w, Tuple const& tp, adjustment adj,
+	    Spec spec, std::false_type)
 	{
 		throw std::invalid_argument
 		{
@@ -144,100 +509,94 @@ private:
 		};
 	}
 
-	template <int I, typename T, typename Writer, typename Tuple>
+	template <int J, typename T, typename Writer, typename Tuple>
 	static
-	void do_format(Writer w, Tuple tp, adjustment adj)
+	void do_format(Writer w, Tuple const& tp, adjustment adj)
 	{
+		formatter<T> f;
 
-		decide_justification<T>(w, adj, 0);
-		do_format<I, T>(w, tp);
-		w.justify_content();
+		output_justified<T>(w, adj, f, std::get<J>(tp));
 	}
 
-	template <int I, typename T, typename Writer, typename Tuple,
+	template <int J, typename T, typename Writer, typename Tuple,
 	          typename Spec>
 	static
-	void do_format(Writer w, Tuple tp, adjustment adj, Spec spec)
+	void do_format(Writer w, Tuple const& tp, adjustment adj, Spec spec)
 	{
-
-		decide_justification<T>(w, adj, 0);
-		do_format_with_spec<I, T>(w, tp, spec,
+		do_format_with_spec<J, T>(w, tp, adj, spec,
 		    std::is_constructible<formatter<T>, Spec>());
-		w.justify_content();
 	}
+};
 
-	template <typename T, typename Writer>
-	static
-	void decide_justification(Writer& w, adjustment adj, ...)
+[[noreturn]] inline
+void throw_arg_index_out_of_range()
+{
+	throw std::out_of_range
 	{
-		if (adj != adjustment::left)
-			w.padding_left();
-	}
+	    "tuple index out of range"
+	};
+}
 
-	template <typename T, typename Writer>
-	static
-	void decide_justification(Writer& w, adjustment adj,
-	    typename formatter<T>::default_left_justified* = 0)
+// Up to this many arguments, the one for a field is found by comparing
+// its index with each in turn, which lets the formatting of all of them
+// be inlined; past it, by one indirect call through a table indexed
+// from 1.
+constexpr std::size_t arg_table_threshold = 16;
+
+template <typename Tuple, typename Writer, typename... Opts,
+          std::size_t... I>
+inline
+void write_arg_in(int n, Tuple const& tp, Writer w,
+    std::index_sequence<I...>, std::false_type, Opts... o)
+{
+	int _[] =
 	{
-		if (adj == adjustment::right)
-			w.padding_left();
-	}
-};
+		0, (n == int(I) + 1 ? (write_arg_at_impl<int(I) + 1>::apply(
+		    tp, w, o...), 0) : 0)...
+	};
+	(void)_;
+}
 
-template <int Low, int High, int Mid>
-struct write_arg_at_impl<Low, High, Mid, If_ct<(Low < High)>>
+template <typename Tuple, typename Writer, typename... Opts,
+          std::size_t... I>
+inline
+void write_arg_in(int n, Tuple const& tp, Writer w,
+    std::index_sequence<I...>, std::true_type, Opts... o)
 {
-	template <typename Tuple, typename Writer, typename... Opts>
-	static
-	void apply(int n, Tuple tp, Writer w, Opts... o)
+	using fn = void (*)(Tuple const&, Writer, Opts...);
+
+	static constexpr fn table[] =
 	{
-		if (n < Mid)
-			write_arg_at_impl<Low, Mid - 1>::apply(n, tp, w, o...);
-		else if (n == Mid)
-			write_arg_at_impl<Mid, Mid>::apply(n, tp, w, o...);
-		else
-			write_arg_at_impl<Mid + 1, High>::apply(n, tp, w, o...);
-	}
-};
+		nullptr, &write_arg_at_impl<int(I) + 1>::template
+		    apply<Tuple, Writer, Opts...>...
+	};
+
+	table[n](tp, w, o...);
+}
 
 template <typename Tuple, typename Writer, typename... Opts>
 inline
 void write_arg_at(int n, Tuple tp, Writer w, Opts... o)
 {
-	write_arg_at_impl<1, std::tuple_size<Tuple>{}>::apply(n, tp, w, o...);
-}
+	constexpr auto size = std::tuple_size<Tuple>::value;
 
-template <int Low, int High, int Mid = (Low + High) / 2, typename = void>
-struct arg_as_int_at_impl;
+	if (n < 1 or n > int(size))
+		throw_arg_index_out_of_range();
 
-template <int Low, int High, int Mid>
-struct arg_as_int_at_impl<Low, High, Mid, If_ct<(Low > High)>>
-{
-	template <typename Tuple>
-	static
-	int apply(int n, Tuple tp)
-	{
-		throw std::out_of_range
-		{
-		    "tuple index out of range"
-		};
-	}
-};
+	write_arg_in(n, tp, w, std::make_index_sequence<size>(),
+	    std::integral_constant<bool, (size > arg_table_threshold)>(),
+	    o...);
+}
 
-template <int Mid>
-struct arg_as_int_at_impl<Mid, Mid, Mid, void>
+// converts the I-th element of a tuple, counting from 1, to int
+template <int I>
+struct arg_as_int_at_impl
 {
 	template <typename Tuple>
 	static
-	int apply(int n, Tuple tp)
+	int apply(Tuple const& tp)
 	{
-		if (n != Mid)
-			throw std::out_of_range
-			{
-			    "tuple index out of range"
-			};
-
-		return do_get_int(std::get<Mid - 1>(tp));
+		return do_get_int(std::get<I - 1>(tp));
 	}
 
 private:
@@ -310,37 +669,69 @@ private:
 	}
 };
 
-template <int Low, int High, int Mid>
-struct arg_as_int_at_impl<Low, High, Mid, If_ct<(Low < High)>>
+template <typename Tuple, std::size_t... I>
+inline
+int arg_as_int_in(int n, Tuple const& tp, std::index_sequence<I...>,
+    std::false_type)
 {
-	template <typename Tuple>
-	static
-	int apply(int n, Tuple tp)
+	int v = 0;
+	int _[] =
 	{
-		if (n < Mid)
-			return arg_as_int_at_impl<Low, Mid - 1>::apply(n, tp);
-		else if (n == Mid)
-			return arg_as_int_at_impl<Mid, Mid>::apply(n, tp);
-		else
-			return arg_as_int_at_impl<Mid + 1, High>::apply(n, tp);
-	}
-};
+		0, (n == int(I) + 1 ?
+		    (v = arg_as_int_at_impl<int(I) + 1>::apply(tp), 0) : 0)...
+	};
+	(void)_;
+
+	return v;
+}
+
+template <typename Tuple, std::size_t... I>
+inline
+int arg_as_int_in(int n, Tuple const& tp, std::index_sequence<I...>,
+    std::true_type)
+{
+	using fn = int (*)(Tuple const&);
+
+	static constexpr fn table[] =
+	{
+		nullptr, &arg_as_int_at_impl<int(I) + 1>::template apply<Tuple>...
+	};
+
+	return table[n](tp);
+}
 
 template <typename Tuple>
 inline
 int arg_as_int_at(int n, Tuple tp)
 {
-	return arg_as_int_at_impl<1, std::tuple_size<Tuple>{}>::apply(n, tp);
+	constexpr auto size = std::tuple_size<Tuple>::value;
+
+	if (n < 1 or n > int(size))
+		throw_arg_index_out_of_range();
+
+	return arg_as_int_in(n, tp, std::make_index_sequence<size>(),
+	    std::integral_constant<bool, (size > arg_table_threshold)>());
 }
 
-template <typename CharT, typename Traits, typename Allocator, typename Tuple>
-void vsformat(std::basic_string<CharT, Traits, Allocator>& buf,
-              basic_string_view<CharT> fmt,
-              Tuple tp)
+// a replacement field; the indices count from 1
+template <typename CharT>
+struct field_spec
+{
+	int arg;
+	int width;
+	int width_arg;	// 0 for a constant width
+	adjustment adj;
+	bool justified;	// false for "{}"
+	basic_string_view<CharT> spec;
+};
+
+// reports the literal text and the replacement fields of fmt to
+// h.on_literal(CharT const*, size_t) and h.on_field(field_spec<CharT>)
+template <typename CharT, typename Handler>
+inline
+void parse_format(basic_string_view<CharT> fmt, Handler& h)
 {
 	using spec_type = basic_string_view<CharT>;
-	using string_type = std::basic_string<CharT, Traits, Allocator>;
-	using writer_type = format_writer<string_type>;
 
 	auto expect_more = [&]()
 	{
@@ -356,16 +747,16 @@ void vsformat(std::basic_string<CharT, Traits, Allocator>& buf,
 
 	while (1)
 	{
-		auto off = fmt.find_first_of(_G("{}"));
+		auto off = find_brace(fmt.data(), fmt.size());
 
-		if (off == spec_type::npos)
+		if (off == fmt.size())
 		{
-			buf.append(fmt.data(), fmt.size());
+			h.on_literal(fmt.data(), fmt.size());
 			break;
 		}
 		else
 		{
-			buf.append(fmt.data(), off);
+			h.on_literal(fmt.data(), off);
 		}
 
 		auto ch = fmt[off];
@@ -379,7 +770,7 @@ void vsformat(std::basic_string<CharT, Traits, Allocator>& buf,
 				    "Single '}' encountered in format string"
 				};
 
-			buf.push_back(_G('}'));
+			h.on_literal(fmt.data(), 1);
 			fmt.remove_prefix(1);
 			continue;
 		}
@@ -392,7 +783,7 @@ void vsformat(std::basic_string<CharT, Traits, Allocator>& buf,
 
 		if (fmt.front() == _G('{'))
 		{
-			buf.push_back(_G('{'));
+			h.on_literal(fmt.data(), 1);
 			fmt.remove_prefix(1);
 			continue;
 		}
@@ -432,22 +823,22 @@ void vsformat(std::basic_string<CharT, Traits, Allocator>& buf,
 
 		if (ch == _G(':'))
 		{
-			adjustment adj = adjustment::unspecified;
-			int width = 0;
+			field_spec<CharT> f = {};
 
+			f.justified = true;
 			expect_more();
 
 			switch (fmt.front())
 			{
 			case _G('<'):
-				adj = adjustment::left;
+				f.adj = adjustment::left;
 				break;
 			case _G('>'):
-				adj = adjustment::right;
+				f.adj = adjustment::right;
 				break;
 			}
 
-			if (adj != adjustment::unspecified)
+			if (f.adj != adjustment::unspecified)
 			{
 				fmt.remove_prefix(1);
 				expect_more();
@@ -455,14 +846,14 @@ void vsformat(std::basic_string<CharT, Traits, Allocator>& buf,
 
 			if (leads_digits(fmt.front()))
 			{
-				width = parse_int(fmt);
+				f.width = parse_int(fmt);
 			}
 			else if (fmt.front() == _G('*'))
 			{
 				fmt.remove_prefix(1);
 
 				if (sequential)
-					width = arg_as_int_at(arg_index++, tp);
+					f.width_arg = arg_index++;
 
 				else if (fmt.empty() or
 				    not leads_digits(fmt.front()))
@@ -472,11 +863,7 @@ void vsformat(std::basic_string<CharT, Traits, Allocator>& buf,
 					};
 
 				else
-					width = arg_as_int_at(parse_int(fmt),
-					    tp);
-
-				if (width < 0)
-					width = 0;
+					f.width_arg = parse_int(fmt);
 			}
 
 			auto off = fmt.find(_G('}'));
@@ -487,21 +874,18 @@ void vsformat(std::basic_string<CharT, Traits, Allocator>& buf,
 				    "unmatched '{' in format"
 				};
 
-			else if (off == 0)
-				write_arg_at(arg_index, tp,
-				    writer_type(buf, width), adj);
-
-			else
-				write_arg_at(arg_index, tp,
-				    writer_type(buf, width), adj,
-				    fmt.substr(0, off));
-
+			f.arg = arg_index;
+			f.spec = fmt.substr(0, off);
+			h.on_field(f);
 			fmt.remove_prefix(off + 1);
 		}
 
 		else if (ch == _G('}'))
 		{
-			write_arg_at(arg_index, tp, writer_type(buf));
+			field_spec<CharT> f = {};
+
+			f.arg = arg_index;
+			h.on_field(f);
 		}
 
 		else
@@ -514,15 +898,794 @@ void vsformat(std::basic_string<CharT, Traits, Allocator>& buf,
 	}
 }
 
-#undef _G
 
-template <typename CharT, typename Allocator>
-struct string_from_allocator
+template <typename Sink, typename Tuple>
+struct format_to_sink
 {
-	using type = std::basic_string<CharT, std::char_traits<CharT>, Allocator>;
-};
-
-}
+	using char_type = typename sink_traits<Sink>::char_type;
+
+	void on_literal(char_type const* s, std::size_t n)
+	{
+		sink_traits<Sink>::append(buf, s, n);
+	}
+
+	void on_field(field_spec<char_type> const& f)
+	{
+		if (not f.justified)
+			return write_arg_at(f.arg, tp,
+			    writer_access::make(buf));
+
+		int width = f.width;
+
+		if (f.width_arg)
+			width = std::max(arg_as_int_at(f.width_arg, tp), 0);
+
+		if (f.spec.empty())
+			write_arg_at(f.arg, tp, writer_access::make(buf, width),
+			    f.adj);
+		else
+			write_arg_at(f.arg, tp, writer_access::make(buf, width),
+			    f.adj, f.spec);
+	}
+
+	Sink& buf;
+	Tuple tp;
+};
+
+// formats into any sink; see sink_traits
+template <typename Sink, typename Tuple>
+void vsformat(Sink& buf,
+              basic_string_view<typename sink_traits<Sink>::char_type> fmt,
+              Tuple tp)
+{
+	format_to_sink<Sink, Tuple> h = { buf, tp };
+
+	parse_format(fmt, h);
+}
+
+template <typename CharT, typename Tuple>
+std::size_t vformatted_size(basic_string_view<CharT> fmt, Tuple tp)
+{
+	counting_buffer<CharT> buf;
+
+	vsformat(buf, fmt, tp);
+
+	return buf.size();
+}
+
+#undef _G
+
+template <typename CharT, typename Tuple>
+CharT* vformat_to(CharT* out, basic_string_view<CharT> fmt, Tuple tp)
+{
+	truncating_buffer<CharT> buf(out, std::size_t(-1));
+
+	vsformat(buf, fmt, tp);
+	buf.settle();
+
+	return out + buf.size();
+}
+
+template <typename OutputIt, typename CharT, typename Tuple>
+OutputIt vformat_to(OutputIt out, basic_string_view<CharT> fmt, Tuple tp)
+{
+	std::basic_string<CharT> buf;
+
+	vsformat(buf, fmt, tp);
+
+	return std::copy(buf.begin(), buf.end(), out);
+}
+
+// the container a back_insert_iterator appends to; the iterator keeps
+// it in a protected member, which a derived class may name
+template <typename Container>
+inline
+Container& container_of(std::back_insert_iterator<Container> const& it)
+{
+	struct access : std::back_insert_iterator<Container>
+	{
+		static Container* get(
+		    std::back_insert_iterator<Container> const& it)
+		{
+			return it.*&access::container;
+		}
+	};
+
+	return *access::get(it);
+}
+
+// formats straight into the container behind a back_inserter if its
+// storage is contiguous
+template <typename Container, typename CharT, typename Tuple>
+auto vformat_to(std::back_insert_iterator<Container> out,
+                basic_string_view<CharT> fmt, Tuple tp)
+	-> If_t
+	<
+	    and_also
+	    <
+		std::is_same<typename sink_traits<Container>::char_type,
+		    CharT>,
+		is_contiguous_sink<Container>
+	    >,
+	    identity_of<std::back_insert_iterator<Container>>
+	>
+{
+	vsformat(container_of(out), fmt, tp);
+
+	return out;
+}
+
+// and into a string first otherwise, such as for a std::deque
+template <typename Container, typename CharT, typename Tuple>
+auto vformat_to(std::back_insert_iterator<Container> out,
+                basic_string_view<CharT> fmt, Tuple tp)
+	-> If_t
+	<
+	    and_also
+	    <
+		std::is_same<typename sink_traits<Container>::char_type,
+		    CharT>,
+		Not<is_contiguous_sink<Container>>
+	    >,
+	    identity_of<std::back_insert_iterator<Container>>
+	>
+{
+	std::basic_string<CharT> buf;
+	auto& c = container_of(out);
+
+	vsformat(buf, fmt, tp);
+	c.insert(c.end(), buf.begin(), buf.end());
+
+	return out;
+}
+
+template <typename CharT, typename Tuple>
+std::size_t vformat_to_n(CharT* out, std::size_t n,
+                         basic_string_view<CharT> fmt, Tuple tp)
+{
+	truncating_buffer<CharT> buf(out, n);
+
+	vsformat(buf, fmt, tp);
+	buf.settle();
+
+	return buf.size();
+}
+
+template <typename Traits, typename Tuple>
+auto format_exact(basic_string_view<typename Traits::char_type> fmt, Tuple tp)
+	-> std::basic_string<typename Traits::char_type, Traits>
+{
+	std::basic_string<typename Traits::char_type, Traits> buf;
+
+	buf.reserve(vformatted_size(fmt, tp));
+	vsformat(buf, fmt, tp);
+
+	return buf;
+}
+
+template <typename CharT, typename Allocator>
+struct string_from_allocator
+{
+	using type = std::basic_string<CharT, std::char_traits<CharT>, Allocator>;
+};
+
+// The type-erased path: the arguments of a call are packed into an
+// array of format_arg, and one vformat_args per character type formats
+// from it into an erased_buffer, so the code of the parser and of the
+// formatters of the common types is not stamped out once per argument
+// list.
+
+enum class arg_type : unsigned char
+{
+	boolean,
+	char_type,
+	int_,
+	uint_,
+	long_long,
+	ulong_long,
+	float_,
+	double_,
+	long_double,
+	string,
+	pointer,
+	custom,	// anything else, formatted through a function pointer
+};
+
+template <arg_type Type>
+using arg_tag = std::integral_constant<arg_type, Type>;
+
+// the type an argument of type T (decayed) is packed as
+template <typename T, typename CharT>
+struct arg_type_of : arg_tag<arg_type::custom> {};
+
+template <typename CharT>
+struct arg_type_of<bool, CharT> : arg_tag<arg_type::boolean> {};
+
+template <typename CharT>
+struct arg_type_of<CharT, CharT> : arg_tag<arg_type::char_type> {};
+
+template <typename CharT>
+struct arg_type_of<signed char, CharT> : arg_tag<arg_type::int_> {};
+
+template <typename CharT>
+struct arg_type_of<short, CharT> : arg_tag<arg_type::int_> {};
+
+template <typename CharT>
+struct arg_type_of<int, CharT> : arg_tag<arg_type::int_> {};
+
+template <typename CharT>
+struct arg_type_of<long, CharT>
+	: arg_tag<sizeof(long) == sizeof(int) ? arg_type::int_ :
+	    arg_type::long_long> {};
+
+template <typename CharT>
+struct arg_type_of<long long, CharT> : arg_tag<arg_type::long_long> {};
+
+template <typename CharT>
+struct arg_type_of<unsigned char, CharT> : arg_tag<arg_type::uint_> {};
+
+template <typename CharT>
+struct arg_type_of<unsigned short, CharT> : arg_tag<arg_type::uint_> {};
+
+template <typename CharT>
+struct arg_type_of<unsigned int, CharT> : arg_tag<arg_type::uint_> {};
+
+template <typename CharT>
+struct arg_type_of<unsigned long, CharT>
+	: arg_tag<sizeof(long) == sizeof(int) ? arg_type::uint_ :
+	    arg_type::ulong_long> {};
+
+template <typename CharT>
+struct arg_type_of<unsigned long long, CharT>
+	: arg_tag<arg_type::ulong_long> {};
+
+template <typename CharT>
+struct arg_type_of<float, CharT> : arg_tag<arg_type::float_> {};
+
+template <typename CharT>
+struct arg_type_of<double, CharT> : arg_tag<arg_type::double_> {};
+
+template <typename CharT>
+struct arg_type_of<long double, CharT> : arg_tag<arg_type::long_double> {};
+
+template <typename CharT>
+struct arg_type_of<basic_string_view<CharT>, CharT>
+	: arg_tag<arg_type::string> {};
+
+template <typename CharT, typename Allocator>
+struct arg_type_of<std::basic_string<CharT, std::char_traits<CharT>,
+    Allocator>, CharT> : arg_tag<arg_type::string> {};
+
+template <typename CharT>
+struct arg_type_of<CharT const*, CharT> : arg_tag<arg_type::string> {};
+
+template <typename CharT>
+struct arg_type_of<CharT*, CharT> : arg_tag<arg_type::string> {};
+
+// a string of another character type is left to its formatter, which
+// decides whether it may be written at all; so is a pointer whose
+// formatter<T*> is specialized for a user type, and one that does not
+// convert to void const*, to a function or to a volatile object
+template <typename T>
+struct is_char_type : std::false_type {};
+
+template <>
+struct is_char_type<char> : std::true_type {};
+
+template <>
+struct is_char_type<wchar_t> : std::true_type {};
+
+template <>
+struct is_char_type<char16_t> : std::true_type {};
+
+template <>
+struct is_char_type<char32_t> : std::true_type {};
+
+template <typename T, typename CharT>
+struct arg_type_of<T*, CharT>
+	: arg_tag<is_char_type<std::remove_cv_t<T>>::value or
+	    not formats_address<T>::value or
+	    std::is_function<T>::value or std::is_volatile<T>::value ?
+	    arg_type::custom : arg_type::pointer> {};
+
+template <typename CharT>
+struct string_arg
+{
+	CharT const* data;
+	std::size_t size;
+};
+
+// visits *p as a T; see arg_visitor below
+template <typename CharT>
+using custom_arg_fn = int (*)(void const* p, erased_buffer<CharT>* buf,
+    field_spec<CharT> const& f, int width);
+
+template <typename CharT>
+struct custom_arg
+{
+	void const* p;
+	custom_arg_fn<CharT> fn;
+};
+
+template <typename CharT>
+struct format_arg
+{
+	arg_type type;
+
+	union
+	{
+		bool b;
+		CharT c;
+		int i;
+		unsigned u;
+		long long ll;
+		unsigned long long ull;
+		float f;
+		double d;
+		long double const* ld;
+		void const* p;
+		string_arg<CharT> s;
+		custom_arg<CharT> custom;
+	};
+};
+
+// formats v as write_arg_at would as an argument of the type T
+template <typename CharT, typename T>
+inline
+void write_arg_value(erased_buffer<CharT>& buf, field_spec<CharT> const& f,
+    int width, T const& v)
+{
+	auto tp = std::forward_as_tuple(v);
+
+	if (not f.justified)
+		write_arg_at(1, tp, writer_access::make(buf));
+	else if (f.spec.empty())
+		write_arg_at(1, tp, writer_access::make(buf, width), f.adj);
+	else
+		write_arg_at(1, tp, writer_access::make(buf, width), f.adj,
+		    f.spec);
+}
+
+// with buf null, returns v as a width; otherwise formats it into *buf
+template <typename CharT>
+struct arg_visitor
+{
+	template <typename T>
+	int operator()(T const& v) const
+	{
+		if (buf == nullptr)
+			return arg_as_int_at(1, std::forward_as_tuple(v));
+
+		write_arg_value(*buf, f, width, v);
+
+		return 0;
+	}
+
+	erased_buffer<CharT>* buf;
+	field_spec<CharT> const& f;
+	int width;
+};
+
+template <typename T, typename CharT>
+int format_custom_arg(void const* p, erased_buffer<CharT>* buf,
+    field_spec<CharT> const& f, int width)
+{
+	arg_visitor<CharT> vis = { buf, f, width };
+
+	return vis(*static_cast<T const*>(p));
+}
+
+template <typename CharT, typename T>
+inline
+void set_arg(format_arg<CharT>& a, T const& v, arg_tag<arg_type::boolean>)
+{
+	a.b = v;
+}
+
+template <typename CharT, typename T>
+inline
+void set_arg(format_arg<CharT>& a, T const& v,
+    arg_tag<arg_type::char_type>)
+{
+	a.c = v;
+}
+
+template <typename CharT, typename T>
+inline
+void set_arg(format_arg<CharT>& a, T const& v, arg_tag<arg_type::int_>)
+{
+	a.i = int(v);
+}
+
+template <typename CharT, typename T>
+inline
+void set_arg(format_arg<CharT>& a, T const& v, arg_tag<arg_type::uint_>)
+{
+	a.u = unsigned(v);
+}
+
+template <typename CharT, typename T>
+inline
+void set_arg(format_arg<CharT>& a, T const& v, arg_tag<arg_type::long_long>)
+{
+	a.ll = v;
+}
+
+template <typename CharT, typename T>
+inline
+void set_arg(format_arg<CharT>& a, T const& v,
+    arg_tag<arg_type::ulong_long>)
+{
+	a.ull = v;
+}
+
+template <typename CharT, typename T>
+inline
+void set_arg(format_arg<CharT>& a, T const& v, arg_tag<arg_type::float_>)
+{
+	a.f = v;
+}
+
+template <typename CharT, typename T>
+inline
+void set_arg(format_arg<CharT>& a, T const& v, arg_tag<arg_type::double_>)
+{
+	a.d = v;
+}
+
+template <typename CharT, typename T>
+inline
+void set_arg(format_arg<CharT>& a, T const& v,
+    arg_tag<arg_type::long_double>)
+{
+	a.ld = &v;
+}
+
+template <typename CharT, typename T>
+inline
+void set_arg(format_arg<CharT>& a, T const& v, arg_tag<arg_type::string>)
+{
+	basic_string_view<CharT> s(v);
+
+	a.s = { s.data(), s.size() };
+}
+
+template <typename CharT, typename T>
+inline
+void set_arg(format_arg<CharT>& a, T const& v, arg_tag<arg_type::pointer>)
+{
+	a.p = v;
+}
+
+template <typename CharT, typename T>
+inline
+void set_arg(format_arg<CharT>& a, T const& v, arg_tag<arg_type::custom>)
+{
+	a.custom = { std::addressof(v), &format_custom_arg<T, CharT> };
+}
+
+template <typename CharT, typename T>
+inline
+format_arg<CharT> make_arg(T const& v)
+{
+	using tag = arg_type_of<std::decay_t<T>, CharT>;
+
+	format_arg<CharT> a;
+	a.type = tag::value;
+	set_arg(a, v, tag());
+
+	return a;
+}
+
+// visits the value of a as the type it was packed as
+template <typename CharT>
+inline
+int visit_arg(format_arg<CharT> const& a, erased_buffer<CharT>* buf,
+    field_spec<CharT> const& f, int width)
+{
+	arg_visitor<CharT> vis = { buf, f, width };
+
+	switch (a.type)
+	{
+	case arg_type::boolean:
+		return vis(a.b);
+	case arg_type::char_type:
+		return vis(a.c);
+	case arg_type::int_:
+		return vis(a.i);
+	case arg_type::uint_:
+		return vis(a.u);
+	case arg_type::long_long:
+		return vis(a.ll);
+	case arg_type::ulong_long:
+		return vis(a.ull);
+	case arg_type::float_:
+		return vis(a.f);
+	case arg_type::double_:
+		return vis(a.d);
+	case arg_type::long_double:
+		return vis(*a.ld);
+	case arg_type::string:
+		return vis(basic_string_view<CharT>(a.s.data, a.s.size));
+	case arg_type::pointer:
+		return vis(a.p);
+	case arg_type::custom:
+		break;
+	}
+
+	return a.custom.fn(a.custom.p, buf, f, width);
+}
+
+template <typename CharT>
+struct format_from_args
+{
+	using char_type = CharT;
+
+	void on_literal(CharT const* s, std::size_t n)
+	{
+		buf.append(s, n);
+	}
+
+	void on_field(field_spec<CharT> const& f)
+	{
+		int width = f.width;
+
+		if (f.justified and f.width_arg)
+			width = std::max(visit_arg<CharT>(at(f.width_arg), nullptr, f,
+			    0), 0);
+
+		visit_arg(at(f.arg), &buf, f, width);
+	}
+
+	format_arg<CharT> const& at(int n) const
+	{
+		if (n < 1 or std::size_t(n) > size)
+			throw std::out_of_range
+			{
+			    "tuple index out of range"
+			};
+
+		return args[n - 1];
+	}
+
+	erased_buffer<CharT>& buf;
+	format_arg<CharT> const* args;
+	std::size_t size;
+};
+
+// the core of format(); instantiated once per character type
+template <typename CharT>
+void vformat_args(erased_buffer<CharT>& buf, basic_string_view<CharT> fmt,
+                  format_arg<CharT> const* args, std::size_t n)
+{
+	format_from_args<CharT> h = { buf, args, n };
+
+	parse_format(fmt, h);
+}
+
+}
+
+// A sink over a character array of a fixed capacity, which drops what
+// does not fit; size() counts all that was written, stored() what is in
+// the array.  data() returns the array with all of it in place.
+template <typename CharT>
+struct basic_span_sink
+{
+	using value_type = CharT;
+	using traits_type = std::char_traits<CharT>;
+	using size_type = std::size_t;
+
+	basic_span_sink(CharT* p, size_type cap) noexcept :
+		buf_(p, cap), p_(p)
+	{}
+
+	basic_span_sink(basic_span_sink const&) = delete;
+	basic_span_sink& operator=(basic_span_sink const&) = delete;
+
+	~basic_span_sink()
+	{
+		buf_.settle();
+	}
+
+	size_type size() const noexcept
+	{
+		return buf_.size();
+	}
+
+	size_type stored() const noexcept
+	{
+		return buf_.stored();
+	}
+
+	CharT* data() noexcept
+	{
+		buf_.settle();
+
+		return p_;
+	}
+
+private:
+	friend struct sink_traits<basic_span_sink>;
+
+	detail::truncating_buffer<CharT> buf_;
+	CharT* p_;
+};
+
+template <typename CharT>
+struct sink_traits<basic_span_sink<CharT>>
+{
+	using char_type = CharT;
+	using traits_type = std::char_traits<CharT>;
+	using size_type = std::size_t;
+
+	static size_type size(basic_span_sink<CharT> const& s)
+	{
+		return s.size();
+	}
+
+	static void push_back(basic_span_sink<CharT>& s, CharT ch)
+	{
+		s.buf_.push_back(ch);
+	}
+
+	static void append(basic_span_sink<CharT>& s, size_type n, CharT ch)
+	{
+		s.buf_.append(n, ch);
+	}
+
+	static void append(basic_span_sink<CharT>& s, CharT const* p,
+	    size_type n)
+	{
+		s.buf_.append(p, n);
+	}
+
+	static void insert(basic_span_sink<CharT>& s, size_type pos,
+	    size_type n, CharT ch)
+	{
+		s.buf_.insert(pos, n, ch);
+	}
+
+	static CharT* extend(basic_span_sink<CharT>& s, size_type n)
+	{
+		return s.buf_.extend(n);
+	}
+};
+
+using span_sink = basic_span_sink<char>;
+using wspan_sink = basic_span_sink<wchar_t>;
+using u16span_sink = basic_span_sink<char16_t>;
+using u32span_sink = basic_span_sink<char32_t>;
+
+template <typename CharT, std::size_t N>
+struct format_arg_store;
+
+// The arguments of a call to format, packed; they refer to the objects
+// they were made from.  See make_format_args and vformat.
+template <typename CharT>
+struct basic_format_args
+{
+	basic_format_args(detail::format_arg<CharT> const* args,
+	    std::size_t n) noexcept :
+		args_(args), size_(n)
+	{}
+
+	template <std::size_t N>
+	basic_format_args(format_arg_store<CharT, N> const& s) noexcept :
+		args_(s.args), size_(N)
+	{}
+
+	detail::format_arg<CharT> const* data() const noexcept
+	{
+		return args_;
+	}
+
+	std::size_t size() const noexcept
+	{
+		return size_;
+	}
+
+private:
+	detail::format_arg<CharT> const* args_;
+	std::size_t size_;
+};
+
+using format_args = basic_format_args<char>;
+using wformat_args = basic_format_args<wchar_t>;
+using u16format_args = basic_format_args<char16_t>;
+using u32format_args = basic_format_args<char32_t>;
+
+template <typename CharT, std::size_t N>
+struct format_arg_store
+{
+	detail::format_arg<CharT> args[N == 0 ? 1 : N];
+};
+
+template <typename CharT = char, typename... T>
+inline
+auto make_format_args(T const&... t)
+	-> format_arg_store<CharT, sizeof...(T)>
+{
+	return {{ detail::make_arg<CharT>(t)... }};
+}
+
+namespace detail {
+
+template <typename Traits, typename Allocator>
+auto vformat_string(Allocator const& a,
+                    basic_string_view<typename Traits::char_type> fmt,
+                    basic_format_args<typename Traits::char_type> args)
+	-> std::basic_string<typename Traits::char_type, Traits, Allocator>
+{
+	memory_buffer<typename Traits::char_type> buf;
+
+	vformat_args(buf, fmt, args.data(), args.size());
+
+	return { buf.data(), buf.size(), a };
+}
+
+template <typename Traits, typename Allocator, typename... T>
+inline
+auto format_string(Allocator const& a,
+                   basic_string_view<typename Traits::char_type> fmt,
+                   std::true_type, T const&... t)
+	-> std::basic_string<typename Traits::char_type, Traits, Allocator>
+{
+	return vformat_string<Traits>(a, fmt,
+	    make_format_args<typename Traits::char_type>(t...));
+}
+
+// other traits do not go through the packed arguments, where strings
+// are viewed with the standard ones
+template <typename Traits, typename Allocator, typename... T>
+inline
+auto format_string(Allocator const& a,
+                   basic_string_view<typename Traits::char_type> fmt,
+                   std::false_type, T const&... t)
+	-> std::basic_string<typename Traits::char_type, Traits, Allocator>
+{
+	std::basic_string
+	<
+	    typename Traits::char_type,
+	    Traits,
+	    Allocator
+	> buf(a);
+
+	buf.reserve(pow2_roundup(fmt.size()));
+	vsformat(buf, fmt, std::forward_as_tuple(t...));
+
+	return buf;
+}
+
+}
+
+// format() with arguments packed by make_format_args
+inline
+std::string vformat(string_view fmt, format_args args)
+{
+	return detail::vformat_string<std::string::traits_type>(
+	    std::allocator<char>(), fmt, args);
+}
+
+inline
+std::wstring vformat(wstring_view fmt, wformat_args args)
+{
+	return detail::vformat_string<std::wstring::traits_type>(
+	    std::allocator<wchar_t>(), fmt, args);
+}
+
+inline
+std::u16string vformat(u16string_view fmt, u16format_args args)
+{
+	return detail::vformat_string<std::u16string::traits_type>(
+	    std::allocator<char16_t>(), fmt, args);
+}
+
+inline
+std::u32string vformat(u32string_view fmt, u32format_args args)
+{
+	return detail::vformat_string<std::u32string::traits_type>(
+	    std::allocator<char32_t>(), fmt, args);
+}
 
 template <typename Traits, typename Allocator, typename... T>
 inline
@@ -531,12 +1694,16 @@ auto format(Allocator const& a,
             T const&... t)
 	-> If_t
 	<
-	    Not
+	    and_also
 	    <
-		std::is_convertible
+		std::is_class<Allocator>,
+		Not
 		<
-		    Allocator,
-		    basic_string_view<typename Traits::char_type>
+		    std::is_convertible
+		    <
+			Allocator,
+			basic_string_view<typename Traits::char_type>
+		    >
 		>
 	    >,
 	    identity_of
@@ -545,17 +1712,10 @@ auto format(Allocator const& a,
 	    >
 	>
 {
-	std::basic_string
-	<
-	    typename Traits::char_type,
-	    Traits,
-	    Allocator
-	> buf(a);
-
-	buf.reserve(detail::pow2_roundup(fmt.size()));
-	detail::vsformat(buf, fmt, std::forward_as_tuple(t...));
+	using CharT = typename Traits::char_type;
 
-	return buf;
+	return detail::format_string<Traits>(a, fmt,
+	    std::is_same<Traits, std::char_traits<CharT>>(), t...);
 }
 
 template <typename Traits, typename... T>
@@ -577,7 +1737,11 @@ inline
 auto format(Allocator const& a, string_view fmt, T const&... t)
 	-> If_t
 	<
-	    Not<std::is_convertible<Allocator, string_view>>,
+	    and_also
+	    <
+		std::is_class<Allocator>,
+		Not<std::is_convertible<Allocator, string_view>>
+	    >,
 	    detail::string_from_allocator<char, Allocator>
 	>
 {
@@ -589,7 +1753,11 @@ inline
 auto format(Allocator const& a, wstring_view fmt, T const&... t)
 	-> If_t
 	<
-	    Not<std::is_convertible<Allocator, wstring_view>>,
+	    and_also
+	    <
+		std::is_class<Allocator>,
+		Not<std::is_convertible<Allocator, wstring_view>>
+	    >,
 	    detail::string_from_allocator<wchar_t, Allocator>
 	>
 {
@@ -601,7 +1769,11 @@ inline
 auto format(Allocator const& a, u16string_view fmt, T const&... t)
 	-> If_t
 	<
-	    Not<std::is_convertible<Allocator, u16string_view>>,
+	    and_also
+	    <
+		std::is_class<Allocator>,
+		Not<std::is_convertible<Allocator, u16string_view>>
+	    >,
 	    detail::string_from_allocator<char16_t, Allocator>
 	>
 {
@@ -613,7 +1785,11 @@ inline
 auto format(Allocator const& a, u32string_view fmt, T const&... t)
 	-> If_t
 	<
-	    Not<std::is_convertible<Allocator, u32string_view>>,
+	    and_also
+	    <
+		std::is_class<Allocator>,
+		Not<std::is_convertible<Allocator, u32string_view>>
+	    >,
 	    detail::string_from_allocator<char32_t, Allocator>
 	>
 {
@@ -648,6 +1824,165 @@ std::u32string format(u32string_view fmt, T const&... t)
 	return format<std::u32string::traits_type>(fmt, t...);
 }
 
+// Writes what format(fmt, t...) would produce to out and returns the end
+// of the output.  Nothing is allocated when out is a pointer to the
+// character type of fmt, and a back_inserter on a sink of that type
+// gets formatted into directly; other iterators are fed from a string.
+template <typename OutputIt, typename... T>
+inline
+OutputIt format_to(OutputIt out, string_view fmt, T const&... t)
+{
+	return detail::vformat_to(out, fmt, std::forward_as_tuple(t...));
+}
+
+template <typename OutputIt, typename... T>
+inline
+OutputIt format_to(OutputIt out, wstring_view fmt, T const&... t)
+{
+	return detail::vformat_to(out, fmt, std::forward_as_tuple(t...));
+}
+
+template <typename OutputIt, typename... T>
+inline
+OutputIt format_to(OutputIt out, u16string_view fmt, T const&... t)
+{
+	return detail::vformat_to(out, fmt, std::forward_as_tuple(t...));
+}
+
+template <typename OutputIt, typename... T>
+inline
+OutputIt format_to(OutputIt out, u32string_view fmt, T const&... t)
+{
+	return detail::vformat_to(out, fmt, std::forward_as_tuple(t...));
+}
+
+template <typename CharT>
+struct format_to_n_result
+{
+	CharT* out;		// past the last character written
+	std::size_t size;	// the length of the untruncated output
+};
+
+// Writes at most the first n characters of what format(fmt, t...) would
+// produce to buf.  The built-in formatters do not allocate for it, but
+// that of bigint_view does.  Once n characters are written, the rest of
+// the output is only counted.
+template <typename... T>
+inline
+format_to_n_result<char> format_to_n(char* buf, std::size_t n,
+                                     string_view fmt, T const&... t)
+{
+	auto sz = detail::vformat_to_n(buf, n, fmt,
+	    std::forward_as_tuple(t...));
+
+	return { buf + std::min(n, sz), sz };
+}
+
+template <typename... T>
+inline
+format_to_n_result<wchar_t> format_to_n(wchar_t* buf, std::size_t n,
+                                        wstring_view fmt, T const&... t)
+{
+	auto sz = detail::vformat_to_n(buf, n, fmt,
+	    std::forward_as_tuple(t...));
+
+	return { buf + std::min(n, sz), sz };
+}
+
+template <typename... T>
+inline
+format_to_n_result<char16_t> format_to_n(char16_t* buf, std::size_t n,
+                                         u16string_view fmt,
+                                         T const&... t)
+{
+	auto sz = detail::vformat_to_n(buf, n, fmt,
+	    std::forward_as_tuple(t...));
+
+	return { buf + std::min(n, sz), sz };
+}
+
+template <typename... T>
+inline
+format_to_n_result<char32_t> format_to_n(char32_t* buf, std::size_t n,
+                                         u32string_view fmt,
+                                         T const&... t)
+{
+	auto sz = detail::vformat_to_n(buf, n, fmt,
+	    std::forward_as_tuple(t...));
+
+	return { buf + std::min(n, sz), sz };
+}
+
+// the number of characters format(fmt, t...) would produce
+template <typename... T>
+inline
+std::size_t formatted_size(string_view fmt, T const&... t)
+{
+	return detail::vformatted_size(fmt, std::forward_as_tuple(t...));
+}
+
+template <typename... T>
+inline
+std::size_t formatted_size(wstring_view fmt, T const&... t)
+{
+	return detail::vformatted_size(fmt, std::forward_as_tuple(t...));
+}
+
+template <typename... T>
+inline
+std::size_t formatted_size(u16string_view fmt, T const&... t)
+{
+	return detail::vformatted_size(fmt, std::forward_as_tuple(t...));
+}
+
+template <typename... T>
+inline
+std::size_t formatted_size(u32string_view fmt, T const&... t)
+{
+	return detail::vformatted_size(fmt, std::forward_as_tuple(t...));
+}
+
+// selects the format() which measures the result first and allocates
+// it exactly once, at the cost of formatting twice
+struct exact_size_t
+{
+	explicit exact_size_t() = default;
+};
+
+constexpr exact_size_t exact_size{};
+
+template <typename... T>
+inline
+std::string format(exact_size_t, string_view fmt, T const&... t)
+{
+	return detail::format_exact<std::string::traits_type>(fmt,
+	    std::forward_as_tuple(t...));
+}
+
+template <typename... T>
+inline
+std::wstring format(exact_size_t, wstring_view fmt, T const&... t)
+{
+	return detail::format_exact<std::wstring::traits_type>(fmt,
+	    std::forward_as_tuple(t...));
+}
+
+template <typename... T>
+inline
+std::u16string format(exact_size_t, u16string_view fmt, T const&... t)
+{
+	return detail::format_exact<std::u16string::traits_type>(fmt,
+	    std::forward_as_tuple(t...));
+}
+
+template <typename... T>
+inline
+std::u32string format(exact_size_t, u32string_view fmt, T const&... t)
+{
+	return detail::format_exact<std::u32string::traits_type>(fmt,
+	    std::forward_as_tuple(t...));
+}
+
 }
 
 #endif
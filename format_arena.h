@@ -0,0 +1,422 @@
+/*-
+ * Copyright (c) 2013 Zhihao Yuan.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _STDEX_FORMAT_ARENA_H
+#define _STDEX_FORMAT_ARENA_H
+
+#include "format.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace stdex {
+
+template <typename CharT>
+struct basic_arena_sink;
+
+// A bump allocator for formatted strings which live as long as, say,
+// a request.  Strings are laid out back to back in blocks obtained
+// from the upstream; reset() makes all of them invalid at once and
+// rewinds to the first block, keeping the blocks for reuse, while
+// release() also returns the blocks to the upstream.  The upstream is
+// operator new, or a memory resource: any type with the allocate(n,
+// alignment) and deallocate(p, n, alignment) of std::pmr::memory_resource,
+// e.g. a std::pmr::monotonic_buffer_resource owned by the request.
+struct format_arena
+{
+	static constexpr std::size_t default_block_size = 4096;
+
+	explicit format_arena(std::size_t block_size = default_block_size) :
+		block_size_(block_size)
+	{}
+
+	// starts with buf[0, n) before taking blocks from the upstream
+	format_arena(void* buf, std::size_t n,
+	    std::size_t block_size = default_block_size) :
+		block_size_(block_size),
+		initial_(static_cast<char*>(buf)),
+		initial_end_(initial_ + n),
+		top_(initial_),
+		end_(initial_end_)
+	{}
+
+	template <typename Resource, typename = decltype(
+	    std::declval<Resource&>().allocate(std::size_t(), std::size_t()))>
+	explicit format_arena(Resource* r,
+	    std::size_t block_size = default_block_size) :
+		block_size_(block_size),
+		upstream_{ r, &resource_allocate<Resource>,
+		    &resource_deallocate<Resource> }
+	{}
+
+	format_arena(format_arena const&) = delete;
+	format_arena& operator=(format_arena const&) = delete;
+
+	~format_arena()
+	{
+		release();
+	}
+
+	void reset() noexcept
+	{
+		cur_ = nullptr;
+		top_ = initial_;
+		end_ = initial_end_;
+	}
+
+	void release() noexcept
+	{
+		while (head_ != nullptr)
+		{
+			auto b = head_;
+			head_ = b->next;
+			deallocate_block(b);
+		}
+
+		next_size_ = 0;
+		reset();
+	}
+
+	// the bytes held by the arena, used or not
+	std::size_t capacity() const noexcept
+	{
+		std::size_t n = initial_end_ - initial_;
+
+		for (auto b = head_; b != nullptr; b = b->next)
+			n += b->size - header_size;
+
+		return n;
+	}
+
+private:
+	template <typename CharT>
+	friend struct basic_arena_sink;
+
+	struct block
+	{
+		block* next;
+		std::size_t size;
+	};
+
+	// the same members whatever the upstream, or the standard in use
+	struct upstream
+	{
+		void* resource;
+		void* (*allocate)(void* resource, std::size_t n);
+		void (*deallocate)(void* resource, void* p, std::size_t n);
+	};
+
+	static void* new_allocate(void*, std::size_t n)
+	{
+		return ::operator new(n);
+	}
+
+	static void new_deallocate(void*, void* p, std::size_t)
+	{
+		::operator delete(p);
+	}
+
+	template <typename Resource>
+	static void* resource_allocate(void* r, std::size_t n)
+	{
+		return static_cast<Resource*>(r)->allocate(n,
+		    alignof(std::max_align_t));
+	}
+
+	template <typename Resource>
+	static void resource_deallocate(void* r, void* p, std::size_t n)
+	{
+		static_cast<Resource*>(r)->deallocate(p, n,
+		    alignof(std::max_align_t));
+	}
+
+	static constexpr std::size_t header_size =
+	    (sizeof(block) + alignof(std::max_align_t) - 1) /
+	    alignof(std::max_align_t) * alignof(std::max_align_t);
+
+	template <typename CharT>
+	CharT* open(std::size_t& cap) noexcept
+	{
+		if (top_ == nullptr)
+		{
+			cap = 0;
+			return nullptr;
+		}
+
+		auto p = align<CharT>(top_);
+
+		if (p > end_)
+		{
+			cap = 0;
+			return nullptr;
+		}
+
+		cap = (end_ - p) / sizeof(CharT);
+
+		return reinterpret_cast<CharT*>(p);
+	}
+
+	// moves the n characters at p to a region with room for at least
+	// want characters, and returns their new place
+	template <typename CharT>
+	CharT* grow(CharT* p, std::size_t n, std::size_t want,
+	    std::size_t& cap)
+	{
+		next_region(want * sizeof(CharT) + alignof(CharT));
+
+		auto q = reinterpret_cast<CharT*>(align<CharT>(top_));
+
+		if (n != 0)
+			std::memcpy(q, p, n * sizeof(CharT));
+
+		cap = (end_ - reinterpret_cast<char*>(q)) / sizeof(CharT);
+
+		return q;
+	}
+
+	void close(void* end) noexcept
+	{
+		top_ = static_cast<char*>(end);
+	}
+
+	template <typename CharT>
+	static char* align(char* p) noexcept
+	{
+		auto a = alignof(CharT);
+		auto u = reinterpret_cast<std::uintptr_t>(p);
+
+		return p + ((a - u % a) % a);
+	}
+
+	// makes the block after the current one, with at least n bytes,
+	// current; blocks too small for the request are left in place
+	void next_region(std::size_t n)
+	{
+		auto b = cur_ != nullptr ? cur_->next : head_;
+
+		if (b == nullptr or b->size - header_size < n)
+		{
+			if (next_size_ == 0)
+				next_size_ = std::max(block_size_,
+				    std::size_t(2 * header_size));
+
+			auto size = std::max(next_size_, n + header_size);
+
+			b = allocate_block(size);
+			b->size = size;
+			next_size_ = 2 * next_size_;
+
+			if (cur_ != nullptr)
+			{
+				b->next = cur_->next;
+				cur_->next = b;
+			}
+			else
+			{
+				b->next = head_;
+				head_ = b;
+			}
+		}
+
+		cur_ = b;
+		top_ = reinterpret_cast<char*>(b) + header_size;
+		end_ = reinterpret_cast<char*>(b) + b->size;
+	}
+
+	block* allocate_block(std::size_t n)
+	{
+		return static_cast<block*>(upstream_.allocate(
+		    upstream_.resource, n));
+	}
+
+	void deallocate_block(block* b) noexcept
+	{
+		upstream_.deallocate(upstream_.resource, b, b->size);
+	}
+
+	std::size_t block_size_;
+	std::size_t next_size_ = 0;
+	block* head_ = nullptr;
+	block* cur_ = nullptr;	// nullptr while in the initial buffer
+	char* initial_ = nullptr;
+	char* initial_end_ = nullptr;
+	char* top_ = nullptr;
+	char* end_ = nullptr;
+	upstream upstream_ = { nullptr, &new_allocate, &new_deallocate };
+};
+
+// Builds one string at the top of a format_arena, moving it to a
+// larger block when it outgrows the current one.  release() keeps the
+// string in the arena; a sink destroyed without release() gives its
+// space back.  At most one sink may be open on an arena at a time.
+template <typename CharT>
+struct basic_arena_sink
+{
+	using value_type = CharT;
+	using traits_type = std::char_traits<CharT>;
+	using size_type = std::size_t;
+
+	explicit basic_arena_sink(format_arena& a) noexcept :
+		a_(a),
+		p_(a.open<CharT>(cap_))
+	{}
+
+	basic_arena_sink(basic_arena_sink const&) = delete;
+	basic_arena_sink& operator=(basic_arena_sink const&) = delete;
+
+	size_type size() const noexcept
+	{
+		return size_;
+	}
+
+	void push_back(CharT ch)
+	{
+		reserve(1);
+		p_[size_++] = ch;
+	}
+
+	void append(size_type n, CharT ch)
+	{
+		reserve(n);
+		traits_type::assign(p_ + size_, n, ch);
+		size_ += n;
+	}
+
+	void append(CharT const* s, size_type n)
+	{
+		reserve(n);
+		traits_type::copy(p_ + size_, s, n);
+		size_ += n;
+	}
+
+	void insert(size_type pos, size_type n, CharT ch)
+	{
+		reserve(n);
+		traits_type::move(p_ + pos + n, p_ + pos, size_ - pos);
+		traits_type::assign(p_ + pos, n, ch);
+		size_ += n;
+	}
+
+	CharT* extend(size_type n)
+	{
+		reserve(n);
+
+		auto p = p_ + size_;
+		size_ += n;
+
+		return p;
+	}
+
+	// the string so far, which stays valid until the arena is reset
+	basic_string_view<CharT> release() noexcept
+	{
+		basic_string_view<CharT> s(p_, size_);
+
+		if (size_ != 0)
+			a_.close(p_ + size_);
+		p_ += size_;
+		cap_ -= size_;
+		size_ = 0;
+
+		return s;
+	}
+
+private:
+	void reserve(size_type n)
+	{
+		if (cap_ - size_ < n)
+			p_ = a_.grow(p_, size_, size_ + n, cap_);
+	}
+
+	format_arena& a_;
+	size_type cap_;
+	CharT* p_;
+	size_type size_ = 0;
+};
+
+using arena_sink = basic_arena_sink<char>;
+using warena_sink = basic_arena_sink<wchar_t>;
+using u16arena_sink = basic_arena_sink<char16_t>;
+using u32arena_sink = basic_arena_sink<char32_t>;
+
+namespace detail {
+
+template <typename CharT, typename Tuple>
+inline
+basic_string_view<CharT> vformat_into_arena(format_arena& a,
+    basic_string_view<CharT> fmt, Tuple tp)
+{
+	basic_arena_sink<CharT> buf(a);
+	vsformat(buf, fmt, tp);
+
+	return buf.release();
+}
+
+}
+
+// Formats into a, without a separate allocation per string; the result
+// stays valid until a is reset or released.
+template <typename... T>
+inline
+string_view format_into_arena(format_arena& a, string_view fmt,
+                              T const&... t)
+{
+	return detail::vformat_into_arena(a, fmt,
+	    std::forward_as_tuple(t...));
+}
+
+template <typename... T>
+inline
+wstring_view format_into_arena(format_arena& a, wstring_view fmt,
+                               T const&... t)
+{
+	return detail::vformat_into_arena(a, fmt,
+	    std::forward_as_tuple(t...));
+}
+
+template <typename... T>
+inline
+u16string_view format_into_arena(format_arena& a, u16string_view fmt,
+                                 T const&... t)
+{
+	return detail::vformat_into_arena(a, fmt,
+	    std::forward_as_tuple(t...));
+}
+
+template <typename... T>
+inline
+u32string_view format_into_arena(format_arena& a, u32string_view fmt,
+                                 T const&... t)
+{
+	return detail::vformat_into_arena(a, fmt,
+	    std::forward_as_tuple(t...));
+}
+
+}
+
+#endif
@@ -0,0 +1,438 @@
+/*-
+ * Copyright (c) 2013 Zhihao Yuan.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _STDEX_FORMAT_CACHE_H
+#define _STDEX_FORMAT_CACHE_H
+
+#include "format.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace stdex {
+
+namespace detail {
+
+// the output of parse_format over a private copy of the format string;
+// a field_spec with arg 0 stands for the literal text in its spec
+template <typename CharT>
+struct parsed_format
+{
+	explicit parsed_format(basic_string_view<CharT> fmt) :
+		text_(new CharT[fmt.size()]),
+		size_(fmt.size())
+	{
+		std::copy(fmt.begin(), fmt.end(), text_.get());
+		recorder r = { segments_ };
+		parse_format(str(), r);
+	}
+
+	basic_string_view<CharT> str() const
+	{
+		return { text_.get(), size_ };
+	}
+
+	template <typename Handler>
+	void replay(Handler& h) const
+	{
+		for (auto& f : segments_)
+		{
+			if (f.arg == 0)
+				h.on_literal(f.spec.data(), f.spec.size());
+			else
+				h.on_field(f);
+		}
+	}
+
+private:
+	struct recorder
+	{
+		void on_literal(CharT const* s, std::size_t n)
+		{
+			if (n == 0)
+				return;
+
+			if (not v.empty() and v.back().arg == 0 and
+			    v.back().spec.data() + v.back().spec.size() == s)
+				v.back().spec = basic_string_view<CharT>(
+				    v.back().spec.data(), v.back().spec.size() + n);
+			else
+			{
+				field_spec<CharT> f = {};
+				f.spec = basic_string_view<CharT>(s, n);
+				v.push_back(f);
+			}
+		}
+
+		void on_field(field_spec<CharT> const& f)
+		{
+			v.push_back(f);
+		}
+
+		std::vector<field_spec<CharT>>& v;
+	};
+
+	std::unique_ptr<CharT[]> text_;
+	std::size_t size_;
+	std::vector<field_spec<CharT>> segments_;
+};
+
+template <typename Sink, typename Tuple>
+void vsformat(Sink& buf,
+              parsed_format<typename sink_traits<Sink>::char_type> const& fmt,
+              Tuple tp)
+{
+	format_to_sink<Sink, Tuple> h = { buf, tp };
+
+	fmt.replay(h);
+}
+
+}
+
+// A bounded map from format strings to their parsed forms.  Each thread
+// looks up a small direct-mapped table of its own first, without locks;
+// on a miss it takes the lock of the shared table, parsing and inserting
+// the format string if needed, and evicting the least recently used
+// entry when full.  Recency is tracked in ticks of the shared table, so
+// hits in the thread-local tables seldom write to shared memory.  A
+// thread may keep using an evicted entry until its own slot is reused.
+template <typename CharT>
+struct basic_format_cache
+{
+	using char_type = CharT;
+	using string_view_type = basic_string_view<CharT>;
+	using parsed_type = detail::parsed_format<CharT>;
+
+	explicit basic_format_cache(std::size_t capacity = 256) :
+		id_(next_id()),
+		capacity_(std::max<std::size_t>(capacity, 1))
+	{}
+
+	basic_format_cache(basic_format_cache const&) = delete;
+	basic_format_cache& operator=(basic_format_cache const&) = delete;
+
+	// the cache used by cached_format
+	static basic_format_cache& global()
+	{
+		static basic_format_cache c;
+
+		return c;
+	}
+
+	std::shared_ptr<parsed_type const> get(basic_string_view<CharT> fmt)
+	{
+		auto h = detail::hash_chars(fmt.data(), fmt.size());
+		auto& s = front_slot(h);
+
+		if (s.owner == id_ and s.hash == h and s.e->fmt.str() == fmt)
+		{
+			touch(*s.e);
+			count(hits_);
+
+			return { s.e, &s.e->fmt };
+		}
+
+		auto e = find_or_insert(fmt, h);
+
+		if (s.busy == 0)
+			s.assign(id_, h, e);
+
+		return { e, &e->fmt };
+	}
+
+	// calls f(parsed_type const&) with the parsed form of fmt
+	template <typename F>
+	void visit(basic_string_view<CharT> fmt, F&& f)
+	{
+		auto h = detail::hash_chars(fmt.data(), fmt.size());
+		auto& s = front_slot(h);
+
+		if (s.owner == id_ and s.hash == h and s.e->fmt.str() == fmt)
+		{
+			touch(*s.e);
+			count(hits_);
+
+			++s.busy;
+			in_use guard = { s };
+			return f(s.e->fmt);
+		}
+
+		auto e = find_or_insert(fmt, h);
+
+		// a slot stays put while a formatting call through it is
+		// running, in case formatting the arguments uses the cache
+		if (s.busy == 0)
+		{
+			s.assign(id_, h, e);
+
+			++s.busy;
+			in_use guard = { s };
+			return f(s.e->fmt);
+		}
+
+		f(e->fmt);
+	}
+
+	std::uint64_t hits() const
+	{
+		return sum(hits_);
+	}
+
+	std::uint64_t misses() const
+	{
+		return sum(misses_);
+	}
+
+	std::size_t size() const
+	{
+		std::lock_guard<std::mutex> lk(mtx_);
+
+		return table_.size();
+	}
+
+	std::size_t capacity() const
+	{
+		std::lock_guard<std::mutex> lk(mtx_);
+
+		return capacity_;
+	}
+
+	void set_capacity(std::size_t n)
+	{
+		std::lock_guard<std::mutex> lk(mtx_);
+
+		capacity_ = std::max<std::size_t>(n, 1);
+
+		while (table_.size() > capacity_)
+			evict_one();
+	}
+
+private:
+	struct entry
+	{
+		explicit entry(basic_string_view<CharT> s) : fmt(s) {}
+
+		parsed_type fmt;
+		std::atomic<std::uint64_t> last_use;
+	};
+
+	struct slot
+	{
+		void assign(std::uint64_t o, std::uint64_t h,
+		    std::shared_ptr<entry> p)
+		{
+			owner = o;
+			hash = h;
+			e = std::move(p);
+		}
+
+		std::uint64_t owner = 0;
+		std::uint64_t hash = 0;
+		std::shared_ptr<entry> e;
+		int busy = 0;
+	};
+
+	struct in_use
+	{
+		~in_use()
+		{
+			--s.busy;
+		}
+
+		slot& s;
+	};
+
+	static constexpr int front_size = 16;
+	static constexpr int shards = 16;
+
+	// counters are sharded by thread to keep hits from contending
+	struct alignas(64) counter
+	{
+		std::atomic<std::uint64_t> n{ 0 };
+	};
+
+	static std::uint64_t next_id()
+	{
+		static std::atomic<std::uint64_t> id{ 0 };
+
+		return ++id;
+	}
+
+	static slot& front_slot(std::uint64_t h)
+	{
+		static thread_local slot front[front_size];
+
+		auto& s = front[h % front_size];
+
+		return s;
+	}
+
+	static int shard()
+	{
+		static std::atomic<int> next{ 0 };
+		static thread_local int i = next++ % shards;
+
+		return i;
+	}
+
+	static void count(counter (&c)[shards])
+	{
+		c[shard()].n.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	static std::uint64_t sum(counter const (&c)[shards])
+	{
+		std::uint64_t n = 0;
+
+		for (auto& x : c)
+			n += x.n.load(std::memory_order_relaxed);
+
+		return n;
+	}
+
+	void touch(entry& e)
+	{
+		auto now = tick_.load(std::memory_order_relaxed);
+
+		if (e.last_use.load(std::memory_order_relaxed) != now)
+			e.last_use.store(now, std::memory_order_relaxed);
+	}
+
+	std::shared_ptr<entry> find_or_insert(basic_string_view<CharT> fmt,
+	    std::uint64_t h)
+	{
+		std::lock_guard<std::mutex> lk(mtx_);
+
+		auto now = tick_.fetch_add(1, std::memory_order_relaxed) + 1;
+		auto r = table_.equal_range(h);
+
+		for (auto it = r.first; it != r.second; ++it)
+		{
+			if (it->second->fmt.str() == fmt)
+			{
+				it->second->last_use.store(now,
+				    std::memory_order_relaxed);
+				count(hits_);
+
+				return it->second;
+			}
+		}
+
+		count(misses_);
+
+		auto e = std::make_shared<entry>(fmt);
+		e->last_use.store(now, std::memory_order_relaxed);
+
+		if (table_.size() >= capacity_)
+			evict_one();
+
+		table_.emplace(h, e);
+
+		return e;
+	}
+
+	void evict_one()
+	{
+		auto victim = table_.begin();
+
+		for (auto it = table_.begin(); it != table_.end(); ++it)
+		{
+			if (it->second->last_use.load(
+			    std::memory_order_relaxed) <
+			    victim->second->last_use.load(
+			    std::memory_order_relaxed))
+				victim = it;
+		}
+
+		table_.erase(victim);
+	}
+
+	std::uint64_t const id_;
+	std::atomic<std::uint64_t> tick_{ 0 };
+	counter hits_[shards];
+	counter misses_[shards];
+	mutable std::mutex mtx_;
+	std::size_t capacity_;
+	std::unordered_multimap<std::uint64_t, std::shared_ptr<entry>> table_;
+};
+
+using format_cache = basic_format_cache<char>;
+using wformat_cache = basic_format_cache<wchar_t>;
+using u16format_cache = basic_format_cache<char16_t>;
+using u32format_cache = basic_format_cache<char32_t>;
+
+template <typename CharT, typename... T>
+inline
+std::basic_string<CharT> cached_format(
+    basic_format_cache<CharT>& cache,
+    typename basic_format_cache<CharT>::string_view_type fmt,
+    T const&... t)
+{
+	std::basic_string<CharT> buf;
+
+	buf.reserve(detail::pow2_roundup(fmt.size()));
+	cache.visit(fmt, [&](detail::parsed_format<CharT> const& f)
+	    {
+		detail::vsformat(buf, f, std::forward_as_tuple(t...));
+	    });
+
+	return buf;
+}
+
+template <typename... T>
+inline
+std::string cached_format(string_view fmt, T const&... t)
+{
+	return cached_format(format_cache::global(), fmt, t...);
+}
+
+template <typename... T>
+inline
+std::wstring cached_format(wstring_view fmt, T const&... t)
+{
+	return cached_format(wformat_cache::global(), fmt, t...);
+}
+
+template <typename... T>
+inline
+std::u16string cached_format(u16string_view fmt, T const&... t)
+{
+	return cached_format(u16format_cache::global(), fmt, t...);
+}
+
+template <typename... T>
+inline
+std::u32string cached_format(u32string_view fmt, T const&... t)
+{
+	return cached_format(u32format_cache::global(), fmt, t...);
+}
+
+}
+
+#endif
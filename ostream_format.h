@@ -30,9 +30,154 @@
 
 #include <ios>
 #include <memory>
+#include <streambuf>
+#include <limits>
 
 namespace stdex {
 
+namespace detail {
+
+// reaches the put area of any basic_streambuf through the protected
+// members inherited here
+template <typename CharT, typename Traits>
+struct put_area : std::basic_streambuf<CharT, Traits>
+{
+	using streambuf_type = std::basic_streambuf<CharT, Traits>;
+
+	static CharT* next(streambuf_type* sb)
+	{
+		return (sb->*&put_area::pptr)();
+	}
+
+	static CharT* end(streambuf_type* sb)
+	{
+		return (sb->*&put_area::epptr)();
+	}
+
+	static void commit(streambuf_type* sb, std::size_t n)
+	{
+		constexpr int m = std::numeric_limits<int>::max();
+
+		for (; n > std::size_t(m); n -= m)
+			(sb->*&put_area::pbump)(m);
+
+		(sb->*&put_area::pbump)(int(n));
+	}
+};
+
+// Writes into the free part of a put area, beyond pptr(), which moves
+// only when commit() is called; output which does not fit is moved to
+// a string, where it is continued.
+template <typename CharT, typename Traits, typename String>
+struct put_area_sink
+{
+	using value_type = CharT;
+	using traits_type = Traits;
+	using size_type = std::size_t;
+	using area = put_area<CharT, Traits>;
+
+	put_area_sink(typename area::streambuf_type* sb, String& spill) :
+		p_(area::next(sb)),
+		cap_(area::end(sb) - p_),
+		spill_(spill)
+	{}
+
+	// whether the output is in the string rather than the put area
+	bool spilled() const noexcept
+	{
+		return spilled_;
+	}
+
+	size_type size() const noexcept
+	{
+		return spilled_ ? spill_.size() : size_;
+	}
+
+	void push_back(CharT ch)
+	{
+		if (fits(1))
+			p_[size_++] = ch;
+		else
+			spill_.push_back(ch);
+	}
+
+	void append(size_type n, CharT ch)
+	{
+		if (fits(n))
+		{
+			traits_type::assign(p_ + size_, n, ch);
+			size_ += n;
+		}
+		else
+			spill_.append(n, ch);
+	}
+
+	void append(CharT const* s, size_type n)
+	{
+		if (fits(n))
+		{
+			traits_type::copy(p_ + size_, s, n);
+			size_ += n;
+		}
+		else
+			spill_.append(s, n);
+	}
+
+	void insert(size_type pos, size_type n, CharT ch)
+	{
+		if (fits(n))
+		{
+			traits_type::move(p_ + pos + n, p_ + pos, size_ - pos);
+			traits_type::assign(p_ + pos, n, ch);
+			size_ += n;
+		}
+		else
+			spill_.insert(pos, n, ch);
+	}
+
+	CharT* extend(size_type n)
+	{
+		if (fits(n))
+		{
+			auto p = p_ + size_;
+			size_ += n;
+
+			return p;
+		}
+
+		auto sz = spill_.size();
+		spill_.append(n, CharT());
+
+		return &spill_[sz];
+	}
+
+private:
+	// false, after moving the output to the string, if n more
+	// characters do not fit in the put area
+	bool fits(size_type n)
+	{
+		if (spilled_)
+			return false;
+
+		if (cap_ - size_ >= n)
+			return true;
+
+		spill_.reserve(2 * (size_ + n));
+		spill_.assign(p_, size_);
+		spilled_ = true;
+
+		return false;
+	}
+
+	CharT* p_;
+	size_type cap_;
+	size_type size_ = 0;
+	bool spilled_ = false;
+	String& spill_;
+};
+
+}
+
 template <typename CharT, typename Traits, typename Allocator>
 struct ostream_format
 {
@@ -66,11 +211,20 @@ struct ostream_format
 				return out_.good();
 
 			clear_buf _{ &buf_ };
+			auto sb = out_.rdbuf();
+
+			// formats in place when the put area looks big enough;
+			// pptr() stays put until the output is complete
+			sink_type direct(sb, buf_);
 
 			try
 			{
-				detail::vsformat(buf_, fmt,
-				    std::forward_as_tuple(t...));
+				if (direct_capacity(sb) >= fmt.size())
+					detail::vsformat(direct, fmt,
+					    std::forward_as_tuple(t...));
+				else
+					detail::vsformat(buf_, fmt,
+					    std::forward_as_tuple(t...));
 			}
 			catch (...)
 			{
@@ -78,6 +232,13 @@ struct ostream_format
 				throw;
 			}
 
+			if (direct.size() != 0 and not direct.spilled())
+			{
+				detail::put_area<CharT, Traits>::commit(sb,
+				    direct.size());
+				return out_.good();
+			}
+
 			auto p = buf_.data();
 			auto n = buf_.size();
 			auto m = std::numeric_limits<std::streamsize>::max();
@@ -115,6 +276,15 @@ struct ostream_format
 
 private:
 	using string_type = std::basic_string<CharT, Traits, Allocator>;
+	using sink_type = detail::put_area_sink<CharT, Traits, string_type>;
+
+	static std::size_t direct_capacity(std::basic_streambuf<CharT,
+	    Traits>* sb)
+	{
+		using area = detail::put_area<CharT, Traits>;
+
+		return area::end(sb) - area::next(sb);
+	}
 
 	void setstate_and_rethrow(std::ios_base::iostate rd)
 	{
@@ -35,6 +35,9 @@
 #include <stdexcept>
 #include <iosfwd>
 
+#include "__scan.h"
+#include "__hash.h"
+
 namespace stdex {
 
 namespace detail {
@@ -47,6 +50,13 @@ using iter = __gnu_cxx::__normal_iterator
 using iter = typename Container::const_pointer;
 #endif
 
+// whether searches may compare the characters as integers, which lets
+// them run on the kernels in __scan.h
+template <typename CharT, typename Traits>
+using plain_char_traits = std::integral_constant<bool,
+    std::is_same<Traits, std::char_traits<CharT>>::value and
+    std::is_integral<CharT>::value and sizeof(CharT) <= 4>;
+
 }
 
 using namespace std::placeholders;
@@ -247,10 +257,7 @@ struct basic_string_view
 		if (n == 0)
 			return pos;
 
-		auto it = std::search(begin() + pos, end(), s, s + n,
-		    traits_eq());
-
-		return offset_from_begin(it);
+		return search(s, pos, n, plain_traits());
 	}
 
 	size_type find(CharT const* s, size_type pos = 0) const
@@ -263,12 +270,7 @@ struct basic_string_view
 		if (pos >= size())
 			return npos;
 
-		auto p = traits_type::find(data() + pos, size() - pos, ch);
-
-		if (p == nullptr)
-			return npos;
-		else
-			return p - data();
+		return find_char(ch, pos, plain_traits());
 	}
 
 	size_type find_first_of(basic_string_view s,
@@ -283,10 +285,7 @@ struct basic_string_view
 		if (pos >= size())
 			return npos;
 
-		auto it = std::find_first_of(begin() + pos, end(), s, s + n,
-		    traits_eq());
-
-		return offset_from_begin(it);
+		return find_of<true>(s, pos, n, plain_traits());
 	}
 
 	size_type find_first_of(CharT const* s, size_type pos = 0) const
@@ -311,14 +310,7 @@ struct basic_string_view
 		if (pos >= size())
 			return npos;
 
-		auto it = std::find_if(begin() + pos, end(),
-		    [=](CharT c)
-		    {
-			return std::none_of(s, s + n,
-			    std::bind(traits_eq(), c, _1));
-		    });
-
-		return offset_from_begin(it);
+		return find_of<false>(s, pos, n, plain_traits());
 	}
 
 	size_type find_first_not_of(CharT const* s, size_type pos = 0) const
@@ -331,10 +323,7 @@ struct basic_string_view
 		if (pos >= size())
 			return npos;
 
-		auto it = std::find_if_not(begin() + pos, end(),
-		    std::bind(traits_eq(), ch, _1));
-
-		return offset_from_begin(it);
+		return find_of<false>(&ch, pos, 1, plain_traits());
 	}
 
 	friend
@@ -351,6 +340,65 @@ struct basic_string_view
 	}
 
 private:
+	using plain_traits = detail::plain_char_traits<CharT, Traits>;
+
+	size_type search(CharT const* s, size_type pos, size_type n,
+	    std::true_type) const
+	{
+		if (n == 1)
+			return find(*s, pos);
+
+		return offset_from_data(
+		    detail::search(data(), pos, size(), s, n));
+	}
+
+	size_type search(CharT const* s, size_type pos, size_type n,
+	    std::false_type) const
+	{
+		auto it = std::search(begin() + pos, end(), s, s + n,
+		    traits_eq());
+
+		return offset_from_begin(it);
+	}
+
+	size_type find_char(CharT ch, size_type pos, std::true_type) const
+	{
+		return offset_from_data(
+		    detail::find_char(data(), pos, size(), ch));
+	}
+
+	size_type find_char(CharT ch, size_type pos, std::false_type) const
+	{
+		auto p = traits_type::find(data() + pos, size() - pos, ch);
+
+		if (p == nullptr)
+			return npos;
+		else
+			return p - data();
+	}
+
+	template <bool Match>
+	size_type find_of(CharT const* s, size_type pos, size_type n,
+	    std::true_type) const
+	{
+		return offset_from_data(
+		    detail::find_of<Match>(data(), pos, size(), s, n));
+	}
+
+	template <bool Match>
+	size_type find_of(CharT const* s, size_type pos, size_type n,
+	    std::false_type) const
+	{
+		auto it = std::find_if(begin() + pos, end(),
+		    [=](CharT c)
+		    {
+			return std::any_of(s, s + n,
+			    std::bind(traits_eq(), c, _1)) == Match;
+		    });
+
+		return offset_from_begin(it);
+	}
+
 	struct traits_eq
 	{
 		constexpr bool operator()(CharT x, CharT y) const noexcept
@@ -367,6 +415,14 @@ private:
 			return it - begin();
 	}
 
+	size_type offset_from_data(size_type i) const
+	{
+		if (i == size())
+			return npos;
+		else
+			return i;
+	}
+
 	const_pointer it_;
 	size_type sz_;
 };
@@ -463,6 +519,15 @@ using wstring_view = basic_string_view<wchar_t>;
 using u16string_view = basic_string_view<char16_t>;
 using u32string_view = basic_string_view<char32_t>;
 
+// the value of std::hash<basic_string_view<CharT>> for s, also in
+// constant expressions, e.g. static_hash("Host"_sv)
+template <typename CharT>
+constexpr
+std::size_t static_hash(basic_string_view<CharT> s)
+{
+	return std::size_t(detail::hash_chars_constant(s.data(), s.size()));
+}
+
 inline namespace literals {
 inline namespace string_literals {
 
@@ -491,4 +556,21 @@ constexpr u32string_view operator"" _sv(char32_t const* str, std::size_t len)
 
 }
 
+namespace std {
+
+template <typename CharT>
+struct hash<stdex::basic_string_view<CharT>>
+{
+	typedef stdex::basic_string_view<CharT> argument_type;
+	typedef std::size_t result_type;
+
+	std::size_t operator()(argument_type s) const noexcept
+	{
+		return std::size_t(stdex::detail::hash_chars(s.data(),
+		    s.size()));
+	}
+};
+
+}
+
 #endif
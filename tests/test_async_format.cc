@@ -0,0 +1,209 @@
+#include "../async_format.h"
+
+#include "assertions.h"
+
+#include <sstream>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using stdex::async_ostream_format;
+using stdex::overflow_policy;
+
+// a stringbuf whose writes wait for open(), once the put area is full
+struct gated_buf : std::stringbuf
+{
+	void open()
+	{
+		std::lock_guard<std::mutex> lk(mtx);
+		opened = true;
+		cv.notify_all();
+	}
+
+	void wait_for_writer()
+	{
+		while (not entered)
+			std::this_thread::yield();
+	}
+
+	int_type overflow(int_type ch) override
+	{
+		wait();
+		return std::stringbuf::overflow(ch);
+	}
+
+	std::streamsize xsputn(char const* s, std::streamsize n) override
+	{
+		wait();
+		return std::stringbuf::xsputn(s, n);
+	}
+
+private:
+	void wait()
+	{
+		entered = true;
+
+		std::unique_lock<std::mutex> lk(mtx);
+		cv.wait(lk, [&] { return opened; });
+	}
+
+	std::mutex mtx;
+	std::condition_variable cv;
+	bool opened = false;
+	std::atomic<bool> entered{ false };
+};
+
+void test_basic()
+{
+	std::ostringstream os;
+	char name[] = "before";
+	std::string fmt = std::string(300, '-') + "{}\n";
+
+	{
+		async_ostream_format<char> log(os);
+
+		assert(log("{} {:>4}\n", "a", 1));
+		assert(log("{} {}\n", name, stdex::string_view(name)));
+		assert(log(fmt, 2));
+
+		std::strcpy(name, "after");
+		fmt.assign(fmt.size(), '?');
+
+		log.flush();
+		assert(os.str() == "a    1\nbefore before\n" +
+		    std::string(300, '-') + "2\n");
+
+		assert(log("{}", 3));
+	}
+
+	// the destructor writes the rest
+	assert(os.str().back() == '3');
+}
+
+void test_drop()
+{
+	gated_buf sb;
+	std::ostream os(&sb);
+	async_ostream_format<char> log(os, 4, overflow_policy::drop);
+
+	assert(log("first\n"));
+	sb.wait_for_writer();
+
+	// one slot is held by the message being written
+	for (int i = 0; i < 20; ++i)
+		assert(log("{}\n", i) == (i < 3));
+
+	assert(log.dropped() == 17);
+
+	sb.open();
+	log.flush();
+	assert(sb.str() == "first\n0\n1\n2\n");
+}
+
+void test_grow()
+{
+	gated_buf sb;
+	std::ostream os(&sb);
+	async_ostream_format<char> log(os, 4, overflow_policy::grow);
+	std::string want = "first\n";
+
+	assert(log("first\n"));
+	sb.wait_for_writer();
+
+	for (int i = 0; i < 200; ++i)
+	{
+		assert(log("{}\n", i));
+		want += std::to_string(i) + "\n";
+	}
+
+	sb.open();
+	log.flush();
+
+	for (int i = 200; i < 300; ++i)
+	{
+		assert(log("{}\n", i));
+		want += std::to_string(i) + "\n";
+	}
+
+	log.flush();
+	assert(log.dropped() == 0);
+	assert(sb.str() == want);
+}
+
+void test_producers(overflow_policy policy)
+{
+	int const threads = 4;
+	int const n = 5000;
+	std::ostringstream os;
+
+	{
+		async_ostream_format<char> log(os, 8, policy);
+		std::vector<std::thread> v;
+
+		for (int t = 0; t < threads; ++t)
+			v.emplace_back([&, t]
+			    {
+				for (int i = 0; i < n; ++i)
+					log("{} {}\n", t, i);
+			    });
+
+		for (auto& th : v)
+			th.join();
+	}
+
+	std::istringstream is(os.str());
+	std::vector<int> next(threads);
+	int t, i, lines = 0;
+
+	while (is >> t >> i)
+	{
+		assert(i == next[t]);
+		++next[t];
+		++lines;
+	}
+
+	assert(lines == threads * n);
+}
+
+void test_failure()
+{
+	std::ostringstream os;
+	async_ostream_format<char> log(os);
+
+	// a malformed message is lost alone
+	log("a{}\n", 1);
+	log("{}");
+	log("b{}\n", 2);
+	log("c{}\n", 3);
+	log.flush();
+
+	assert(log.failed() == 1);
+	assert(os.rdstate() == std::ios_base::goodbit);
+	assert(os.str() == "a1\nb2\nc3\n");
+}
+
+void test_wide()
+{
+	std::wostringstream os;
+
+	{
+		async_ostream_format<wchar_t> log(os, 2);
+
+		for (int i = 0; i < 10; ++i)
+			log(L"{}{}", i, L"é");
+	}
+
+	assert(os.str() == L"0é1é2é3é4é"
+	    L"5é6é7é8é9é");
+}
+
+int main()
+{
+	test_basic();
+	test_drop();
+	test_grow();
+	test_producers(overflow_policy::block);
+	test_producers(overflow_policy::grow);
+	test_failure();
+	test_wide();
+}
@@ -0,0 +1,232 @@
+#include "../binary_log.h"
+
+#include "assertions.h"
+
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <cstdio>
+
+static char const path[] = "test_binary_log.bin";
+
+// a user type whose pointers have a formatter of their own
+struct Tagged
+{
+	int id;
+};
+
+template <>
+struct stdex::formatter<Tagged*>
+{
+	template <typename Writer>
+	void output(Writer w, Tagged* p)
+	{
+		w.send("Tagged@");
+		w.send(char('0' + p->id));
+	}
+};
+
+void noop() {}
+
+// logs each call and keeps what formatting it directly gives
+struct recorder
+{
+	template <typename... T>
+	void operator()(stdex::string_view fmt, T const&... t)
+	{
+		assert(log(fmt, t...));
+		expected.push_back(stdex::format(fmt, t...));
+	}
+
+	stdex::binary_log_writer& log;
+	std::vector<std::string> expected;
+};
+
+void test_round_trip()
+{
+	std::vector<std::string> expected;
+
+	{
+		std::ofstream out(path, std::ios::binary);
+		stdex::binary_log_writer log(out);
+		recorder r = { log, {} };
+
+		int x = 0;
+		std::string big(5000, 'x');
+		char arr[] = "array";
+
+		r("plain text\n");
+		r("{} {}", true, false);
+		r("{:c}|{:3}|{:<3}|", 'a', 'b', 'c');
+		r("{} {}", (signed char)-128, (unsigned char)255);
+		r("{} {}", short(-32768), (unsigned short)65535);
+		r("{} {} {}", 0, std::numeric_limits<int>::min(),
+		    std::numeric_limits<int>::max());
+		r("{} {}", -1L, std::numeric_limits<long>::min());
+		r("{} {}", std::numeric_limits<long long>::min(),
+		    std::numeric_limits<long long>::max());
+		r("{} {} {}", 0U, 4294967295UL,
+		    std::numeric_limits<unsigned long long>::max());
+		r("{:x} {:#o} {:,d}", 255, 8U, 1234567);
+		r("{} {} {}", 0.1f, 1e300, -0.0);
+		r("{:.3f}|{:,f}|{:12}", 3.14159, 1234.5f, 2e-10);
+		r("{}/{}/{}", std::numeric_limits<double>::infinity(),
+		    std::numeric_limits<double>::quiet_NaN(),
+		    std::numeric_limits<double>::denorm_min());
+		r("{}|{:10}|{:>10}|{:s}", "literal", std::string("str"),
+		    stdex::string_view("view"), arr);
+		r("{} {}", std::string(), big);
+		r("{:p}", &x);
+		r("{}", (void*)nullptr);
+		r("{} {}", (unsigned char const*)arr, (int const*)&x);
+		r("{} {:p}", &noop, (int volatile*)&x);
+		r("{:*}|", 6, 'w');
+		r("{2:<*1}|", 3U, 'w');
+		r("{2} {1} {2}", "a", "b");
+
+		// the format string is defined once
+		for (int i = 0; i < 1000; ++i)
+			r("event {:4} of {}\n", i, 1000);
+
+		expected = r.expected;
+	}
+
+	std::ifstream in(path, std::ios::binary);
+	stdex::binary_log_reader rd(in);
+	std::string s;
+
+	assert(rd.version() == 1);
+
+	for (auto& e : expected)
+	{
+		assert(rd.next(s));
+		assert(s == e);
+	}
+
+	assert(not rd.next(s));
+	assert(not rd.next(s));
+}
+
+	// only what formatting would write as an address is logged as one;
+	// these would not compile as arguments
+	using stdex::detail::has_binary_log_code;
+	static_assert(has_binary_log_code<void const*>::value, "");
+	static_assert(has_binary_log_code<int*>::value, "");
+	static_assert(not has_binary_log_code<wchar_t const*>::value, "");
+	static_assert(not has_binary_log_code<char16_t*>::value, "");
+	static_assert(not has_binary_log_code<Tagged*>::value, "");
+
+void test_size()
+{
+	std::ostringstream out;
+
+	{
+		stdex::binary_log_writer log(out);
+
+		for (int i = 0; i < 100; ++i)
+			log("a rather long format string, {} and {}\n", i, 'c');
+	}
+
+	auto n = out.str().size();
+
+	// the header, one definition, and at most 8 bytes an event
+	assert(n < 12 + 48 + 100 * 8);
+}
+
+// the errors of formatting come out of the reader
+void test_deferred_errors()
+{
+	std::stringstream ss;
+
+	{
+		stdex::binary_log_writer log(ss);
+
+		log("{} {} {}", 'a', 'b');
+		log("{:*}", 2147483648LL);
+		log("{:*}", -2147483649L);
+		log("{:*}", 8.0);
+		log("{:s}", 42);
+		log("{0}");
+		log("ok");
+	}
+
+	stdex::binary_log_reader rd(ss);
+	std::string s;
+
+	assert_throw(std::out_of_range, rd.next(s));
+	assert_throw(std::overflow_error, rd.next(s));
+	assert_throw(std::underflow_error, rd.next(s));
+	assert_throw(std::invalid_argument, rd.next(s));
+	assert_throw(std::invalid_argument, rd.next(s));
+	assert_throw(std::invalid_argument, rd.next(s));
+	assert(rd.next(s));
+	assert(s == "ok");
+	assert(not rd.next(s));
+}
+
+void test_malformed()
+{
+	{
+		std::istringstream in("STDXLOG!\x01");
+		assert_throw(std::invalid_argument,
+		    stdex::binary_log_reader rd(in));
+	}
+
+	{
+		std::istringstream in(std::string("STDXBLOG\x02\0\0\0", 12));
+		assert_throw(std::invalid_argument,
+		    stdex::binary_log_reader rd(in));
+	}
+
+	std::ostringstream out;
+
+	{
+		stdex::binary_log_writer log(out);
+		log("{}-{}", std::string("text"), 1.5);
+	}
+
+	auto full = out.str();
+	auto defined = std::size_t(12 + 3 + 5);
+
+	// every cut within a record is detected
+	for (auto n = full.size() - 1; n > 12; --n)
+	{
+		std::istringstream in(full.substr(0, n));
+		stdex::binary_log_reader rd(in);
+		std::string s;
+
+		if (n == defined)
+			assert(not rd.next(s));
+		else
+			assert_throw(std::invalid_argument, rd.next(s));
+	}
+
+	{
+		std::istringstream in(full.substr(0, 12) + "\x09");
+		stdex::binary_log_reader rd(in);
+		std::string s;
+
+		assert_throw(std::invalid_argument, rd.next(s));
+	}
+
+	// a corrupted length is not taken at its word
+	for (auto len : { std::string("\xff\xff\xff\xff\xff\xff\xff\xff\x7f"),
+	    std::string("\x80\x80\x08") })
+	{
+		std::istringstream in(full.substr(0, 12) +
+		    std::string("\x01\x00", 2) + len + "{}");
+		stdex::binary_log_reader rd(in);
+		std::string s;
+
+		assert_throw(std::invalid_argument, rd.next(s));
+	}
+}
+
+int main()
+{
+	test_round_trip();
+	test_size();
+	test_deferred_errors();
+	test_malformed();
+	std::remove(path);
+}
@@ -0,0 +1,146 @@
+#include "../chrono_format.h"
+
+#include "assertions.h"
+
+#include <random>
+#include <ctime>
+
+using stdex::format;
+
+template <typename Duration>
+using sys_time = std::chrono::time_point<std::chrono::system_clock,
+    Duration>;
+
+using std::chrono::seconds;
+using std::chrono::milliseconds;
+using std::chrono::microseconds;
+using std::chrono::nanoseconds;
+
+int main()
+{
+	sys_time<seconds> epoch(seconds(0));
+	sys_time<nanoseconds> t(nanoseconds(1700000000123456789));
+
+	assert(format("{}", epoch) == "1970-01-01 00:00:00");
+	assert(format("{}", t) == "2023-11-14 22:13:20.123456789");
+	assert(format("{:%Y-%m-%dT%H:%M:%S.%fZ}", t) ==
+	    "2023-11-14T22:13:20.123456789Z");
+	assert(format("{:%T.%3f|%6f|%f}", t) ==
+	    "22:13:20.123|123456|123456789");
+	assert(format("{:%FT%T.%fZ}",
+	    std::chrono::time_point_cast<microseconds>(t)) ==
+	    "2023-11-14T22:13:20.123456Z");
+	assert(format("{:%T.%f %9f}",
+	    std::chrono::time_point_cast<milliseconds>(t)) ==
+	    "22:13:20.123 123000000");
+	assert(format("{:%S.%f}|", epoch) == "00.|");
+	assert(format(u"{:>24%D %R}|", t) == u"          11/14/23 22:13|");
+	assert(format(L"{:%a %A %b %h %B %e %j %u %w}", epoch) ==
+	    L"Thu Thursday Jan Jan January  1 001 4 4");
+	assert(format("{:%I %p %z %Z %s %% %n%t}", t) ==
+	    "10 PM +0000 UTC 1700000000 % \n\t");
+
+	// before the epoch, and the fraction of a negative count
+	sys_time<milliseconds> before(milliseconds(-1));
+
+	assert(format("{}", before) == "1969-12-31 23:59:59.999");
+	assert(format("{:%F %s}", sys_time<seconds>(seconds(-62135596800))) ==
+	    "0001-01-01 -62135596800");
+	assert(format("{:%Y %y}", sys_time<seconds>(seconds(-62198755200))) ==
+	    "-1 99");
+	assert(format("{:%F}", sys_time<seconds>(seconds(253402300800))) ==
+	    "10000-01-01");
+	assert(format("{:%F %T}", sys_time<seconds>(seconds(951782400))) ==
+	    "2000-02-29 00:00:00");
+
+	// the cache is keyed on the pattern and the second
+	char const* const expected[] =
+	{
+	    "22:13:20.123", "22:13:20.423", "22:13:20.723", "22:13:21.023",
+	};
+
+	for (int i = 0; i < 4; ++i)
+		assert(format("{:%T.%3f}", t + milliseconds(300 * i)) ==
+		    expected[i]);
+
+	assert(format("{:%T.%3f}", t + milliseconds(900)) == "22:13:21.023");
+	assert(format("{:%M:%S}", t + milliseconds(900)) == "13:21");
+	assert(format("{:%T.%3f}", t + milliseconds(100)) == "22:13:20.223");
+
+	assert_throw(std::invalid_argument, format("{:%Q}", epoch));
+	assert_throw(std::invalid_argument, format("{:%}", epoch));
+	assert_throw(std::invalid_argument, format("{:%0f}", epoch));
+	assert_throw(std::invalid_argument, format("{:%3}", epoch));
+
+	// against gmtime_r and strftime, for the years 1000 to 9999
+	std::mt19937_64 gen;
+	std::uniform_int_distribution<long long> dist(-30610224000,
+	    253402300799);
+	char const pattern[] = "%a %A %b %B %d %D %e %F %H %I %j %m %M %p "
+	    "%R %S %T %u %w %y %Y %z %%";
+	char buf[256];
+
+	for (int i = 0; i < 200000; ++i)
+	{
+		std::time_t s = i < 100000 ? dist(gen) : i * 86399LL;
+		std::tm tm;
+
+		gmtime_r(&s, &tm);
+		std::strftime(buf, sizeof(buf), pattern, &tm);
+		assert(format(std::string("{:") + pattern + "}",
+		    sys_time<seconds>(seconds(s))) == buf);
+	}
+
+	// durations
+	using namespace std::chrono;
+	using std::chrono::duration;
+
+	assert(format("{:ms} past!", seconds(1) + milliseconds(100)) ==
+	    "1100ms past!");
+	assert(format("{} {} {} {}", nanoseconds(5), microseconds(-5),
+	    milliseconds(0), seconds(42)) == "5ns -5us 0ms 42s");
+	assert(format("{} {} {}", minutes(3), hours(-1),
+	    duration<int, std::ratio<86400>>(7)) == "3min -1h 7d");
+	assert(format("{} {}", duration<int, std::ratio<1, 3>>(5),
+	    duration<long, std::ratio<2>>(5)) == "5[1/3]s 5[2]s");
+
+	assert(format("{:s} {:s} {:ms}", milliseconds(1100), microseconds(-5),
+	    seconds(2)) == "1.1s -0.000005s 2000ms");
+	assert(format("{:min} {:min} {:h}", seconds(90), seconds(100),
+	    minutes(90)) == "1.5min 1.666666667min 1.5h");
+	assert(format("{:s}", duration<int, std::ratio<1, 3>>(4)) ==
+	    "1.333333333s");
+	assert(format("{:.3s} {:.0s} {:.0s} {:.0s}", milliseconds(1100),
+	    milliseconds(1500), milliseconds(2500), milliseconds(-2501)) ==
+	    "1.100s 2s 2s -3s");
+	assert(format("{:.2ms} {:.1us}", nanoseconds(1234567),
+	    nanoseconds(999)) == "1.23ms 1.0us");
+	assert(format("{:.1ms}", nanoseconds(9950000)) == "10.0ms");
+	assert(format("{:.2}", milliseconds(7)) == "7.00ms");
+	assert(format("{:>10.1ms}|{:<8s}|", microseconds(1250),
+	    milliseconds(-30)) == "     1.2ms|-0.03s  |");
+	assert(format(u"{:us}", milliseconds(3)) == u"3000us");
+
+	assert(format("{:auto} {:auto} {:auto} {:auto}", nanoseconds(999),
+	    nanoseconds(1000), microseconds(1500), milliseconds(-1500)) ==
+	    "999ns 1us 1.5ms -1.5s");
+	assert(format("{:.1auto} {:auto}", microseconds(999999), hours(1)) ==
+	    "1000.0ms 3600s");
+
+	assert(format("{} {:ms} {:.1s}", duration<double>(1.5),
+	    duration<double>(1.5), duration<float, std::milli>(250)) ==
+	    "1.5s 1500.0ms 0.2s");
+	assert(format("{:auto}", duration<double, std::micro>(-0.5)) ==
+	    "-500.0ns");
+
+	assert(format("{}", nanoseconds(std::numeric_limits<long long>::min()))
+	    == "-9223372036854775808ns");
+	assert(format("{:ns}", hours(2562047)) == "9223369200000000000ns");
+	assert_throw(std::overflow_error,
+	    format("{:ns}", hours(std::numeric_limits<long long>::max())));
+
+	assert_throw(std::invalid_argument, format("{:m}", seconds(1)));
+	assert_throw(std::invalid_argument, format("{:.s}", seconds(1)));
+	assert_throw(std::invalid_argument, format("{:s3}", seconds(1)));
+	assert_throw(std::invalid_argument, format("{:.19s}", seconds(1)));
+}
@@ -0,0 +1,78 @@
+#include "../compiled_format.h"
+#include "../chrono_format.h"
+
+#include "assertions.h"
+
+#include <utility>
+
+using stdex::format;
+using stdex::compiled_format;
+using stdex::wcompiled_format;
+using namespace stdex::literals;
+
+int main()
+{
+	compiled_format<int, char const*, double> f("{}: {:>8} [{:.2f}]");
+
+	assert(f.render(42, "abc", 3.14159) ==
+	    format("{}: {:>8} [{:.2f}]", 42, "abc", 3.14159));
+	assert(f.render(-1, "", 0.) == "-1:          [0.00]");
+
+	std::string s = "> ";
+	f.render(s, 7, "x", 1.);
+	assert(s == "> 7:        x [1.00]");
+
+	compiled_format<int, int> g("{{{2:<*1}}}|{1:x}{{");
+	assert(g.render(5, 12) == "{12   }|5{");
+	assert(g.render(-3, 12) == "{12}|-3{");
+	assert(g.render(5, 12) == format("{{{2:<*1}}}|{1:x}{{", 5, 12));
+
+	compiled_format<int, int, int> h("{:*}|{}");
+	assert(h.render(4, 1, 2) == "   1|2");
+
+	compiled_format<> lit("no fields {{here}}");
+	assert(lit.render() == "no fields {here}");
+	assert(compiled_format<>("").render().empty());
+
+	compiled_format<std::string> m("[{:<5}]");
+	auto m2 = std::move(m);
+	assert(m2.render("ab") == "[ab   ]");
+
+	wcompiled_format<long long, bool> w(L"{:,} {}");
+	assert(w.render(1234567, true) == L"1,234,567 true");
+
+	using namespace std::chrono;
+	compiled_format<system_clock::time_point> t("at {:%F}");
+	auto t2 = std::move(t);
+	assert(t2.render(system_clock::time_point()) == "at 1970-01-01");
+
+	assert_throw(std::out_of_range, compiled_format<int>("{2}"));
+	assert_throw(std::out_of_range, compiled_format<int>("{:*3}"));
+	assert_throw(std::out_of_range, compiled_format<>("{}"));
+	assert_throw(std::invalid_argument, compiled_format<int>("{:q}"));
+	assert_throw(std::invalid_argument, compiled_format<int>("{"));
+	assert_throw(std::invalid_argument, compiled_format<bool>("{:x}"));
+
+	assert(format("{}: {:>8} [{:.2f}]"_fmt, 42, "abc", 3.14159) ==
+	    format("{}: {:>8} [{:.2f}]", 42, "abc", 3.14159));
+	assert(format("{{{2:<*1}}}|{1:x}{{"_fmt, 5, 12) == "{12   }|5{");
+	assert(format("{{{2:<*1}}}|{1:x}{{"_fmt, -3, 12) == "{12}|-3{");
+	assert(format("{:*}|{}"_fmt, 4u, 1, 2) == "   1|2");
+	assert(format("a}}b{{c"_fmt) == "a}b{c");
+	assert(format(""_fmt).empty());
+	assert(format("{:<6}|{:>6}|{:6}"_fmt, true, 'c', "s") ==
+	    "true  |     c|s     ");
+	assert(format(L"{:,} {}"_fmt, 1234567LL, L"w") == L"1,234,567 w");
+	assert(format(u"{2}{1}"_fmt, u'a', u'b') == u"ba");
+	assert(format(U"{:x}"_fmt, 255) == U"ff");
+
+	for (int i = 0; i < 3; ++i)
+		assert(format("{:.1f}"_fmt, i + .25) ==
+		    format("{:.1f}", i + .25));
+
+	stdex::string_view sv = "{:>4}"_fmt;
+	assert(format(sv, 1) == "   1");
+
+	assert_throw(std::invalid_argument, format("{:q}"_fmt, 1));
+	assert_throw(std::overflow_error, format("{:*}"_fmt, 1u << 31, 1));
+}
@@ -0,0 +1,75 @@
+#include "../decimal.h"
+
+#include "assertions.h"
+
+#include <cstdio>
+#include <limits>
+
+using stdex::format;
+using stdex::decimal;
+using stdex::fixed_decimal;
+
+int main()
+{
+	assert(format("{}", decimal(12345, 2)) == "123.45");
+	assert(format("{} {}", decimal(-5, 3), decimal(0, 2)) ==
+	    "-0.005 0.00");
+	assert(format("{} {}", decimal(42), decimal(-7, -3)) == "42 -7000");
+	assert(format("{} {}", decimal(0, -3), decimal(1, 20)) ==
+	    "0 0.00000000000000000001");
+	assert(format("{}", decimal(std::numeric_limits<std::int64_t>::min(),
+	    18)) == "-9.223372036854775808");
+
+	assert(format("{:.4}|{:.0}|{:.2}", decimal(12345, 2), decimal(5, -2),
+	    decimal(-7, -1)) == "123.4500|500|-70.00");
+	assert(format("{:.1} {:.1} {:.1} {:.1}", decimal(125, 2),
+	    decimal(135, 2), decimal(1251, 3), decimal(-125, 2)) ==
+	    "1.2 1.4 1.3 -1.2");
+	assert(format("{:.1a} {:.1a} {:.1a}", decimal(125, 2),
+	    decimal(124, 2), decimal(-125, 2)) == "1.3 1.2 -1.3");
+	assert(format("{:.1z} {:.1z}", decimal(129, 2), decimal(-129, 2)) ==
+	    "1.2 -1.2");
+	assert(format("{:.1c} {:.1c}", decimal(121, 2), decimal(-129, 2)) ==
+	    "1.3 -1.2");
+	assert(format("{:.1n} {:.1n}", decimal(129, 2), decimal(-121, 2)) ==
+	    "1.2 -1.3");
+	assert(format("{:.2f} {:.1f} {:f}", decimal(-1255, 3), decimal(135, 2),
+	    decimal(5, 1)) == "-1.26 1.4 0.5");
+	assert(format("{:.2} {:.0}", decimal(99995, 4), decimal(-5, 1)) ==
+	    "10.00 -0");
+	assert(format("{:.0a} {:.0c} {:.0n}", decimal(-5, 1), decimal(1, 25),
+	    decimal(-1, 25)) == "-1 1 -1");
+	assert(format("{:.0}", decimal(std::numeric_limits<std::int64_t>::max(),
+	    19)) == "1");
+	assert(format("{:.0}", decimal(std::numeric_limits<std::int64_t>::min(),
+	    0)) == "-9223372036854775808");
+
+	assert(format("{:,}", decimal(123456789, 2)) == "1,234,567.89");
+	assert(format("{:,.0}", decimal(-123456789, -3)) ==
+	    "-123,456,789,000");
+	assert(format("{:>12,.1}|", decimal(1234567, 2)) == "    12,345.7|");
+	assert(format(u"{:<8}|", decimal(-1, 2)) == u"-0.01   |");
+
+	using cents = fixed_decimal<2>;
+	static_assert(cents::scale() == 2, "");
+
+	assert(format("{} {:.1a}", cents(199), cents(-1005)) == "1.99 -10.1");
+
+	assert_throw(std::invalid_argument, format("{:.2x}", decimal(1)));
+	assert_throw(std::invalid_argument, format("{:.}", decimal(1)));
+	assert_throw(std::overflow_error, format("{:.2147483647}",
+	    decimal(-1, 5)));
+	assert_throw(std::invalid_argument, format("{:ee}", decimal(1)));
+	assert_throw(std::invalid_argument, format("{:.1,}", decimal(1)));
+
+	// every cent amount against the integer arithmetic
+	char buf[32];
+
+	for (long long i = -200000; i <= 200000; i += 7)
+	{
+		std::snprintf(buf, sizeof(buf), "%s%lld.%02lld",
+		    i < 0 ? "-" : "", (i < 0 ? -i : i) / 100,
+		    (i < 0 ? -i : i) % 100);
+		assert(format("{}", cents(i)) == buf);
+	}
+}
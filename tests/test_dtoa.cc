@@ -0,0 +1,248 @@
+#define _STDEX_TESTING
+#include "../__formatter.h"
+
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+using stdex::detail::decimal_string;
+
+template <typename RealType>
+std::string repr(RealType v)
+{
+	std::string s;
+	stdex::format_writer<std::string> w(s);
+	stdex::formatter<RealType>().output(w, v);
+
+	return s;
+}
+
+template <typename RealType>
+std::string fixed(RealType v, int precision)
+{
+	auto spec = "." + std::to_string(precision) + "f";
+	std::string s;
+	stdex::format_writer<std::string> w(s);
+	stdex::formatter<RealType>(stdex::string_view(spec)).output(w, v);
+
+	return s;
+}
+
+std::string trimmed(decimal_string d)
+{
+	while (d.size > 1 and d.digits[d.size - 1] == '0')
+		--d.size;
+
+	return std::string(d.digits, d.size) + "@" + std::to_string(d.point);
+}
+
+template <typename RealType>
+RealType parse(std::string const& s);
+
+template <>
+float parse(std::string const& s)
+{
+	return std::strtof(s.data(), nullptr);
+}
+
+template <>
+double parse(std::string const& s)
+{
+	return std::strtod(s.data(), nullptr);
+}
+
+template <>
+long double parse(std::string const& s)
+{
+	return std::strtold(s.data(), nullptr);
+}
+
+// significant digits
+int digits_of(std::string const& s)
+{
+	std::string m;
+
+	for (char c : s.substr(0, s.find('e')))
+		if ('0' <= c and c <= '9')
+			m.push_back(c);
+
+	auto first = m.find_first_not_of('0');
+
+	if (first == std::string::npos)
+		return 0;
+
+	return int(m.find_last_not_of('0') - first + 1);
+}
+
+// no decimal with fewer digits round-trips
+template <typename RealType>
+bool is_shortest(RealType v, std::string const& s)
+{
+	char buf[32];
+	int n = digits_of(s);
+
+	if (n <= 1)
+		return true;
+
+	std::snprintf(buf, sizeof(buf), "%.*e", n - 2, double(v));
+
+	return parse<RealType>(buf) != v;
+}
+
+int main(int argc, char* argv[])
+{
+	// every 4099th finite float and a sample of random doubles, a tenth
+	// as many long doubles; "all" sweeps all the floats and tries ten
+	// times the values, which takes minutes.  A stride can be given.
+	std::uint32_t stride = 4099;
+	int samples = 100000;
+
+	if (argc > 1 and std::strcmp(argv[1], "all") == 0)
+	{
+		stride = 1;
+		samples *= 10;
+	}
+	else if (argc > 1)
+		stride = std::max(std::atoi(argv[1]), 1);
+
+	// the costlier checks on about one float in 4093
+	std::uint32_t every = std::max(4093 / stride, 1u);
+
+	for (std::uint64_t i = 0, k = 0; i < 0x7f800000; i += stride, ++k)
+	{
+		float f;
+		auto bits = std::uint32_t(i);
+		std::memcpy(&f, &bits, sizeof(f));
+
+		auto s = repr(f);
+		assert(parse<float>(s) == f);
+
+		if (k % every == 0)
+		{
+			assert(repr(-f) == "-" + s);
+			assert(is_shortest(f, s));
+		}
+	}
+
+	std::mt19937_64 g(stride);
+
+	for (int i = 0; i < samples; ++i)
+	{
+		double d;
+		auto bits = g() & ~(std::uint64_t(1) << 63);
+		std::memcpy(&d, &bits, sizeof(d));
+
+		if (not std::isfinite(d))
+			continue;
+
+		auto s = repr(d);
+		assert(parse<double>(s) == d);
+		assert(is_shortest(d, s));
+
+		if (i % 97 == 0 and d != 0)
+		{
+			decimal_string x, y;
+			stdex::detail::shortest(d, x);
+			stdex::detail::shortest_exact
+			    <
+				stdex::detail::bigint_limbs<double>()
+			    >
+			    (stdex::detail::decompose(d), y);
+			assert(trimmed(x) == trimmed(y));
+		}
+	}
+
+	char buf[400];
+
+	for (int i = 0; i < samples; ++i)
+	{
+		double d;
+		auto bits = g();
+		std::memcpy(&d, &bits, sizeof(d));
+
+		// mostly the range where the 64-bit path applies
+		if (i % 4)
+			d = std::ldexp(double(g() >> 11), int(g() % 80) - 60);
+		else if (not std::isfinite(d) or std::fabs(d) > 1e100)
+			continue;
+
+		int precision = g() % 24;
+
+		std::snprintf(buf, sizeof(buf), "%.*f", precision, d);
+		assert(fixed(d, precision) == buf);
+
+		auto x = stdex::detail::decompose(std::fabs(d));
+		std::uint64_t q;
+		std::uint32_t chunks[stdex::detail::fixed_chunks<double>()];
+		int frac, zeros;
+
+		if (stdex::detail::fixed_fast(x, precision, q))
+		{
+			auto n = stdex::detail::fixed_exact
+			    <
+				stdex::detail::fixed_limbs<double>()
+			    >
+			    (x, precision, chunks, frac, zeros);
+
+			assert(n <= 3 and frac + zeros == precision);
+			assert(q == (chunks[0] + 1000000000ull * (n > 1 ?
+			    chunks[1] + (n > 2 ? 1000000000ull * chunks[2] :
+			    0) : 0)) * stdex::detail::power_of_10(zeros));
+		}
+	}
+
+	for (int i = 0; i < samples / 10; ++i)
+	{
+		long double v = std::ldexp((long double)g(),
+		    int(g() % 400) - 300);
+		int precision = g() % 40;
+
+		std::snprintf(buf, sizeof(buf), "%.*Lf", precision, v);
+		assert(fixed(v, precision) == buf);
+	}
+
+	assert(fixed(0.5, 0) == "0");
+	assert(fixed(1.5, 0) == "2");
+	assert(fixed(-0.0005, 3) == "-0.001");
+	assert(fixed(5e-324, 3) == "0.000");
+	assert(fixed(1e-7f, 10) == "0.0000001000");
+	assert(fixed(1e22, 1) == "10000000000000000000000.0");
+	assert(fixed(std::numeric_limits<double>::max(), 0).size() == 309);
+
+	{
+		auto m = std::numeric_limits<double>::denorm_min();
+		auto s = fixed(m, 1080);
+
+		std::snprintf(buf, sizeof(buf), "%.300f", m);
+		assert(s.size() == 1082 and s.compare(0, 302, buf) == 0);
+		assert(s.compare(1070, 12, "265625000000") == 0);
+		assert(fixed(std::numeric_limits<float>::max(), 2) ==
+		    "340282346638528859811704183484516925440.00");
+	}
+
+	for (int i = 0; i < samples / 10; ++i)
+	{
+		long double v = std::ldexp((long double)g() / 3,
+		    int(g() % 32000) - 16000);
+
+		if (not std::isfinite(v) or v == 0)
+			continue;
+
+		assert(parse<long double>(repr(v)) == v);
+	}
+
+	assert(repr(0.0) == "0.0");
+	assert(repr(-0.0f) == "-0.0");
+	assert(repr(1e16) == "1e+16");
+	assert(repr(1.5e-5) == "1.5e-05");
+	assert(repr(5e-324) == "5e-324");
+	assert(repr(1.7976931348623157e308) == "1.7976931348623157e+308");
+	assert(repr(std::numeric_limits<float>::denorm_min()) == "1e-45");
+	assert(repr(std::numeric_limits<double>::infinity()) == "inf");
+	assert(repr(-std::numeric_limits<float>::infinity()) == "-inf");
+	assert(repr(std::numeric_limits<double>::quiet_NaN()) == "nan");
+	assert(repr(1.0L) == "1.0");
+	assert(repr(0.1L) == "0.1");
+}
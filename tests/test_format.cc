@@ -2,8 +2,34 @@
 
 #include "assertions.h"
 
+#include <deque>
+#include <limits>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
 using stdex::format;
 
+// counted, for the paths which must not allocate
+std::size_t allocations = 0;
+
+void* operator new(std::size_t n)
+{
+	++allocations;
+
+	if (auto p = std::malloc(n ? n : 1))
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
 struct NoSpec {};
 
 template <>
@@ -16,9 +42,143 @@ struct stdex::formatter<NoSpec>
 	}
 };
 
+// a user type whose pointers have a formatter of their own
+struct Tagged
+{
+	int id;
+};
+
+template <>
+struct stdex::formatter<Tagged*>
+{
+	template <typename Writer>
+	void output(Writer w, Tagged* p)
+	{
+		w.send("Tagged@");
+		w.send(char('0' + p->id));
+	}
+};
+
+void noop() {}
+
+// writes n copies of its character, in pieces
+struct Run
+{
+	char ch;
+	int n;
+};
+
+int run_outputs = 0;
+
+template <>
+struct stdex::formatter<Run>
+{
+	template <typename Writer>
+	void output(Writer w, Run r)
+	{
+		++run_outputs;
+
+		for (int i = 0; i < r.n; i += 3)
+		{
+			auto p = w.extend(std::min(3, r.n - i));
+			std::fill(p, p + std::min(3, r.n - i), r.ch);
+		}
+	}
+};
+
+// a fixed-size packet, adapted through sink_traits; overflow is dropped
+struct packet
+{
+	char data[16];
+	std::size_t len = 0;
+	std::size_t dropped = 0;
+};
+
+template <>
+struct stdex::sink_traits<packet>
+{
+	using char_type = char;
+	using traits_type = std::char_traits<char>;
+	using size_type = std::size_t;
+
+	static size_type size(packet const& s)
+	{
+		return s.len + s.dropped;
+	}
+
+	static void push_back(packet& s, char ch)
+	{
+		append(s, &ch, 1);
+	}
+
+	static void append(packet& s, size_type n, char ch)
+	{
+		while (n--)
+			push_back(s, ch);
+	}
+
+	static void append(packet& s, char const* p, size_type n)
+	{
+		auto k = std::min(n, sizeof(s.data) - s.len);
+		std::copy(p, p + k, s.data + s.len);
+		s.len += k;
+		s.dropped += n - k;
+	}
+
+	static void insert(packet& s, size_type pos, size_type n, char ch)
+	{
+		std::string t(s.data, s.len);
+		t.insert(pos, n, ch);
+		s.len = s.dropped = 0;
+		append(s, t.data(), t.size());
+	}
+
+	static char* extend(packet& s, size_type n)
+	{
+		assert(s.len + n <= sizeof(s.data));
+		s.len += n;
+
+		return s.data + s.len - n;
+	}
+};
+
+// schoolbook decimal conversion of little-endian 64-bit limbs
+std::string decimal_of(std::vector<std::uint64_t> const& limbs)
+{
+	std::string s = "0";
+
+	for (auto i = limbs.size(); i--;)
+	{
+		for (int half = 1; half >= 0; --half)
+		{
+			std::uint64_t carry = (limbs[i] >> (32 * half)) &
+			    0xffffffff;
+
+			for (auto it = s.rbegin(); it != s.rend(); ++it)
+			{
+				auto t = (*it - '0') * 0x100000000ull + carry;
+				*it = char('0' + t % 10);
+				carry = t / 10;
+			}
+
+			for (; carry; carry /= 10)
+				s.insert(s.begin(), char('0' + carry % 10));
+		}
+	}
+
+	return s;
+}
 
 int main()
 {
+	// format() packs its arguments; this goes through the tuple
+	auto via_tuple = [](stdex::string_view fmt, auto const&... t)
+	{
+		std::string s;
+		stdex::detail::vsformat(s, fmt, std::forward_as_tuple(t...));
+		return s;
+	};
+
 	assert(format("") == "");
 	assert(format(std::allocator<char>(), "") == "");
 
@@ -41,6 +201,18 @@ int main()
 	assert_throw(std::out_of_range, format("{} {} {}", 'a', 'a'));
 
 	assert_throw(std::out_of_range, format("{2147483647}"));
+
+	// more than arg_table_threshold elements index a table
+	assert(via_tuple("{17}|{9}|{1}|{16}|{1:>*17}", 1, 2, 3, 4, 5, 6, 7, 8,
+	    9, 10, 11, 12, 13, 14, 15, 16, 3) == "3|9|1|16|  1");
+	assert(stdex::formatted_size("{17:*16}|{16}", 1, 2, 3, 4, 5, 6, 7, 8,
+	    9, 10, 11, 12, 13, 14, 15, 16, 30) == 19);
+	assert_throw(std::out_of_range, via_tuple("{18}", 1, 2, 3, 4, 5, 6, 7,
+	    8, 9, 10, 11, 12, 13, 14, 15, 16, 17));
+	assert_throw(std::out_of_range, via_tuple("{1:*18}", 1, 2, 3, 4, 5, 6,
+	    7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17));
+	assert_throw(std::invalid_argument, via_tuple("{1:*17}", 1, 2, 3, 4, 5,
+	    6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, "17"));
 	assert_throw(std::overflow_error, format("{2147483648}"));
 
 	assert(format("{} {}", true, false) == "true false");
@@ -79,4 +251,385 @@ int main()
 	assert_throw(std::overflow_error, format("{:*}", 4294967295UL));
 	assert_throw(std::underflow_error, format("{:*}", -2147483649L));
 	assert_throw(std::invalid_argument, format("{:*}", 8.0));
+
+	assert(format("{}", 0) == "0");
+	assert(format("{} {}", 9, 10) == "9 10");
+	assert(format("{} {}", 99, 100) == "99 100");
+	assert(format("{} {}", -1, -10) == "-1 -10");
+	assert(format("{}", std::numeric_limits<int>::max()) == "2147483647");
+	assert(format("{}", std::numeric_limits<int>::min()) == "-2147483648");
+	assert(format("{}", std::numeric_limits<long long>::min()) ==
+	    "-9223372036854775808");
+	assert(format("{}", std::numeric_limits<unsigned long long>::max()) ==
+	    "18446744073709551615");
+	assert(format("{} {}", (signed char)-128, (unsigned char)255) ==
+	    "-128 255");
+	assert(format("{} {}", short(-32768), (unsigned short)65535) ==
+	    "-32768 65535");
+	assert(format("{} {}", 4294967295U, -2147483647L) ==
+	    "4294967295 -2147483647");
+
+	assert(format("{:d}|{:6d}|{:<6}", 42, -42, 42UL) == "42|   -42|42    ");
+	assert(format(u"{:5}", 123) == u"  123");
+	assert(format(U"{:d}", -7LL) == U"-7");
+	assert_throw(std::invalid_argument, format("{:q}", 42));
+	assert_throw(std::invalid_argument, format("{:#}", 'a'));
+	assert_throw(std::invalid_argument, format("{:dx}", 42));
+
+	assert(format("{:x} {:X} {:o} {:b}", 255, 255U, 8, 5) ==
+	    "ff FF 10 101");
+	assert(format("{:#x} {:#X} {:#o} {:#b} {:#}", 255, 255U, 8, 5, 7) ==
+	    "0xff 0XFF 0o10 0b101 7");
+	assert(format("{:x} {:#b} {:o}", 0, 0, 0) == "0 0b0 0");
+	assert(format("{:#x} {:b}", -255, (signed char)-128) ==
+	    "-0xff -10000000");
+	assert(format("{:X}", std::numeric_limits<long long>::min()) ==
+	    "-8000000000000000");
+	assert(format("{:x}", 0x0123456789abcdefULL) == "123456789abcdef");
+	assert(format("{:o}", ~0ULL) == "1777777777777777777777");
+	assert(format("{:b}", ~0ULL) == std::string(64, '1'));
+	assert(format("{:>8#x}|{:<6X}|", 0xbeefU, (short)-10) ==
+	    "  0xbeef|-A    |");
+	assert(format(u"{:#x}", 48879L) == u"0xbeef");
+
+	assert(format("{}", (void*)0) == "0x0");
+	assert(format("{:p}", (int*)0x7ffd1234abc0) == "0x7ffd1234abc0");
+	assert(format("{:>6p}", (void const*)0x10) == "  0x10");
+	assert(format(U"{}", (double*)0xff) == U"0xff");
+	assert_throw(std::invalid_argument, format("{:x}", (void*)0));
+	assert_throw(std::invalid_argument, format("{:d}", 'a'));
+
+	assert(format("{} {} {}", 0.5, -2.0, 1e100) == "0.5 -2.0 1e+100");
+	assert(format("{} {}", 0.1f, 1e-7f) == "0.1 1e-07");
+	assert(format("{:>8}|{:<6}|", 3.25, 0.0L) == "    3.25|0.0   |");
+	assert(format(U"{}", -1.5) == U"-1.5");
+
+	assert(format("{:.2f}|{:8.3f}|{:<6.1f}|", 2.675, -1.0005f, 0.25L) ==
+	    "2.67|  -1.000|0.2   |");
+	assert(format("{:f} {:.0f} {:.0f}", 1.0 / 3, 0.5, 2.5) ==
+	    "0.333333 0 2");
+	assert(format(u"{:.1f}", -0.04) == u"-0.0");
+	assert(format("{:.3f} {:.1f}", std::numeric_limits<double>::infinity(),
+	    std::numeric_limits<double>::quiet_NaN()) == "inf nan");
+	assert_throw(std::invalid_argument, format("{:.2}", 1.0));
+	assert_throw(std::invalid_argument, format("{:.f}", 1.0));
+	assert_throw(std::invalid_argument, format("{:x}", 1.0));
+	assert_throw(std::overflow_error, format("{:.2147483648f}", 1.0));
+	assert_throw(std::overflow_error, format("{:.2147483647f}", -1.0));
+	assert_throw(std::overflow_error, format("{:,.2147483646f}", 1e300));
+
+	assert(format("{:,} {:,d} {:,} {:,}", 1234567, -1000, 999, 0) ==
+	    "1,234,567 -1,000 999 0");
+	assert(format("{:>12,}|", std::numeric_limits<long long>::min()) ==
+	    "-9,223,372,036,854,775,808|");
+	assert(format(u"{:#,}", 100000U) == u"100,000");
+	assert(format("{:,.2f} {:,f} {:,.0f}", 1234567.891, -1e6, 999.5) ==
+	    "1,234,567.89 -1,000,000.000000 1,000");
+	assert(format("{:,} {:,} {:,}", 1234567.5, 1e15, 0.00012) ==
+	    "1,234,567.5 1,000,000,000,000,000.0 0.00012");
+	assert(format("{:,} {:,.1f}", 1e16, 1e20) ==
+	    "1e+16 100,000,000,000,000,000,000.0");
+	assert_throw(std::invalid_argument, format("{:,x}", 42));
+	assert_throw(std::invalid_argument, format("{:,,}", 42));
+	assert_throw(std::invalid_argument, format("{:,.2}", 1.0));
+
+#if defined(__SIZEOF_INT128__)
+	using i128 = __int128;
+	using u128 = unsigned __int128;
+
+	auto u128_max = ~u128(0);
+	auto i128_min = i128(u128(1) << 127);
+
+	assert(format("{}", u128_max) ==
+	    "340282366920938463463374607431768211455");
+	assert(format("{}", i128_min) ==
+	    "-170141183460469231731687303715884105728");
+	assert(format("{} {}", i128(-1), u128(0)) == "-1 0");
+	assert(format("{}", u128(10000000000000000000ull) * 10) ==
+	    "100000000000000000000");
+	assert(format("{:x}", u128_max) == std::string(32, 'f'));
+	assert(format("{:#X}", u128(1) << 64) == "0X10000000000000000");
+	assert(format("{:o}", u128_max) ==
+	    "3" + std::string(42, '7'));
+	assert(format("{:b}", u128_max >> 1) == std::string(127, '1'));
+	assert(format("{:,}", u128_max) ==
+	    "340,282,366,920,938,463,463,374,607,431,768,211,455");
+	assert(format("{:,}", i128(-1000000000000000000) * 1000) ==
+	    "-1,000,000,000,000,000,000,000");
+	assert(format(U"{:>42}", i128_min + 1) ==
+	    U"  -170141183460469231731687303715884105727");
+
+	for (u128 i = 1, j = 1; j < 40; i *= 10, ++j)
+	{
+		auto s = format("{}", i);
+		assert(s.size() == j and s.front() == '1');
+		assert(format("{}", i - 1).size() == (j == 1 ? 1 : j - 1));
+		assert(format("{:,}", i).size() == j + (j - 1) / 3);
+	}
+#endif
+
+	using stdex::bigint_view;
+
+	std::uint64_t limbs[] = { 1, 0, 0 };
+
+	assert(format("{}", bigint_view(limbs, 0, true)) == "0");
+	assert(format("{:#x}", bigint_view(limbs, 3, true)) == "-0x1");
+	assert(format("{}", bigint_view(limbs + 1, 2, true)) == "0");
+	limbs[2] = 1;
+	assert(format("{}", bigint_view(limbs, 3)) ==
+	    "340282366920938463463374607431768211457");
+	assert(format("{:x} {:#b}", bigint_view(limbs, 3),
+	    bigint_view(limbs + 1, 2)) ==
+	    "100000000000000000000000000000001 0b1" + std::string(64, '0'));
+	assert(format("{:o}", bigint_view(limbs, 3)) ==
+	    "4" + std::string(41, '0') + "1");
+	assert(format("{:,}", bigint_view(limbs, 3, true)) ==
+	    "-340,282,366,920,938,463,463,374,607,431,768,211,457");
+	assert_throw(std::invalid_argument,
+	    format("{:,b}", bigint_view(limbs, 3)));
+
+	std::mt19937_64 gen;
+
+	for (std::size_t n : { 2, 3, 31, 32, 33, 64, 65, 100, 257, 600 })
+	{
+		std::vector<std::uint64_t> v(n);
+
+		for (auto& x : v)
+			x = gen();
+
+		if (n % 3 == 0)
+			v[n / 2] = v[n / 3] = 0;
+
+		auto s = format("{}", bigint_view(v.data(), n));
+		assert(s == decimal_of(v));
+		assert(format("{:,}", bigint_view(v.data(), n)).size() ==
+		    s.size() + (s.size() - 1) / 3);
+
+		std::fill(v.begin(), v.end(), ~0ull);
+		s = format("{:X}", bigint_view(v.data(), n, true));
+		assert(s == "-" + std::string(16 * n, 'F'));
+		assert(format("{}", bigint_view(v.data(), n)) ==
+		    decimal_of(v));
+	}
+
+	for (unsigned long long i = 1, j = 1; j < 20; i *= 10, ++j)
+	{
+		auto s = format("{}", i);
+		assert(s.size() == j and s.front() == '1');
+		assert(format("{}", i - 1).size() == (j == 1 ? 1 : j - 1));
+	}
+
+	assert(stdex::formatted_size("") == 0);
+	assert(stdex::formatted_size("{{{}}}", 42) == 4);
+	assert(stdex::formatted_size("{:>10}|{:<*}|", -1.5, 6, 'c') == 18);
+	assert(stdex::formatted_size(L"{:,}", 1234567) == 9);
+	assert(stdex::formatted_size(u"{:x}", 255u) == 2);
+	assert(stdex::formatted_size(U"{} {}", true, U"ab") == 7);
+
+	std::vector<std::uint64_t> big(40, ~0ull);
+	auto bs = format("{:>800}|{:.3f}|{:b}", bigint_view(big.data(), 40),
+	    3.14159, ~0ull);
+	assert(stdex::formatted_size("{:>800}|{:.3f}|{:b}",
+	    bigint_view(big.data(), 40), 3.14159, ~0ull) == bs.size());
+	assert(format(stdex::exact_size, "{:>800}|{:.3f}|{:b}",
+	    bigint_view(big.data(), 40), 3.14159, ~0ull) == bs);
+	assert(format(stdex::exact_size, L"{:<4}|{}", 1, L"w") == L"1   |w");
+	assert(format(stdex::exact_size, u"{}", u'c') == u"c");
+	assert(format(stdex::exact_size, U"") == U"");
+	assert_throw(std::out_of_range, stdex::formatted_size("{2}", 1));
+
+	char cb[64];
+	auto e = stdex::format_to(cb, "{:>6}|{}", 42, "ab");
+	assert(std::string(cb, e) == "    42|ab");
+
+	std::vector<wchar_t> wv;
+	stdex::format_to(std::back_inserter(wv), L"{:x}{{", 255);
+	assert(std::wstring(wv.begin(), wv.end()) == L"ff{");
+
+	auto check_n = [&](std::size_t n, std::string const& want)
+	{
+		std::fill(std::begin(cb), std::end(cb), '#');
+		auto r = stdex::format_to_n(cb, n, "{:>8}|{:<5}|{:>7}", 123456,
+		    'c', -1.25);
+		assert(r.size == want.size());
+		assert(r.out == cb + std::min(n, want.size()));
+		assert(std::string(cb, r.out) == want.substr(0, n));
+		assert(cb[r.out - cb] == '#');
+	};
+
+	std::string full = format("{:>8}|{:<5}|{:>7}", 123456, 'c', -1.25);
+	for (std::size_t n = 0; n <= full.size() + 1; ++n)
+		check_n(n, full);
+
+	auto cut_digits = [&](std::size_t n, std::string const& want)
+	{
+		std::fill(std::begin(cb), std::end(cb), '#');
+		auto r = stdex::format_to_n(cb, n, "{:<3}{:,}x", -7,
+		    1234567890123ull);
+		assert(r.size == want.size());
+		assert(std::string(cb, r.out) == want.substr(0, n));
+	};
+
+	full = format("{:<3}{:,}x", -7, 1234567890123ull);
+	for (std::size_t n = 0; n <= full.size(); ++n)
+		cut_digits(n, full);
+
+	// a field longer than the scratch area of the buffer
+	char fb[64];
+	auto fe = format("{:.2f}", 1e300);
+	auto allocated = allocations;
+	auto fr = stdex::format_to_n(fb, sizeof(fb), "{:.2f}", 1e300);
+	assert(allocations == allocated);
+	assert(fr.size == 304 and fe.compare(0, 64, fb, 64) == 0);
+
+	fe = format("{:,.300f}|{:.3f}", -1e200, 5e-324);
+	allocated = allocations;
+	fr = stdex::format_to_n(fb, sizeof(fb), "{:,.300f}|{:.3f}", -1e200,
+	    5e-324);
+	assert(allocations == allocated);
+	assert(fr.size == 574 and fe.compare(0, 64, fb, 64) == 0);
+	assert(fe.compare(0, 9, "-99,999,9") == 0 and
+	    fe.compare(fe.size() - 7, 7, "0|0.000") == 0);
+
+	char16_t ub[4];
+	auto ur = stdex::format_to_n(ub, 4, u"{}{}", 12345, u"x");
+	assert(ur.size == 6 and ur.out == ub + 4);
+	assert(std::u16string(ub, ur.out) == u"1234");
+
+	std::vector<char> vc = { '>' };
+	stdex::format_to(std::back_inserter(vc), "{:>5}|{:<4}|{:x}", 1.5,
+	    true, 255);
+	assert(std::string(vc.begin(), vc.end()) == ">  1.5|true|ff");
+
+	std::vector<char32_t> v32;
+	char32_t z = U'z';
+	stdex::detail::vsformat(v32, U"{:>4}", std::forward_as_tuple(z));
+	assert(std::u32string(v32.begin(), v32.end()) == U"   z");
+
+	std::string bs2;
+	stdex::format_to(std::back_inserter(bs2), "{}{}", 'a', 1);
+	assert(bs2 == "a1");
+
+	// not contiguous; formatted aside, then inserted
+	std::deque<char> dq(500, '.');
+	stdex::format_to(std::back_inserter(dq), "{}|{}", 123456789012345678LL,
+	    1.5);
+	assert(std::string(dq.begin() + 500, dq.end()) ==
+	    "123456789012345678|1.5");
+	static_assert(not stdex::is_contiguous_sink<std::deque<char>>::value,
+	    "");
+
+	char sb[8];
+	int i42 = 42, i7 = 789;
+	stdex::span_sink ss(sb, sizeof(sb));
+	stdex::detail::vsformat(ss, "{:>6}|{}", std::forward_as_tuple(i42, i7));
+	assert(ss.size() == 10 and ss.stored() == 8);
+	assert(std::string(ss.data(), 8) == "    42|7");
+
+	// the part of a number crossing the end
+	char sb2[4];
+	{
+		stdex::span_sink ss2(sb2, sizeof(sb2));
+		stdex::detail::vsformat(ss2, "ab{}", std::forward_as_tuple(i7));
+	}
+	assert(std::string(sb2, 4) == "ab78");
+
+	packet pk;
+	int i9 = 9;
+	stdex::detail::vsformat(pk, "id={:<4}|{}", std::forward_as_tuple(i9,
+	    "abcdefgh"));
+	assert(std::string(pk.data, pk.len) == "id=9   |abcdefgh");
+	assert(pk.dropped == 0);
+	stdex::detail::vsformat(pk, "{}", std::forward_as_tuple("more"));
+	assert(pk.len == 16 and pk.dropped == 4);
+
+	assert(format("{:>8}|{:<8}|{:8}", NoSpec(), NoSpec(), NoSpec()) ==
+	    "  NoSpec|NoSpec  |  NoSpec");
+	assert(format(L"[{:>*}]", 6, Run{ 'x', 4 }) == L"[  xxxx]");
+	assert(format("{:>400}", Run{ 'y', 300 }) ==
+	    std::string(100, ' ') + std::string(300, 'y'));
+	assert(format("{:>4}", Run{ 'z', 300 }) == std::string(300, 'z'));
+	assert(run_outputs == 3);
+	assert(stdex::formatted_size("{:>400}", Run{ 'y', 300 }) == 400);
+
+	std::vector<char> rv;
+	stdex::format_to(std::back_inserter(rv), "{:>5}{:>3}", Run{ 'a', 2 },
+	    NoSpec());
+	assert(std::string(rv.begin(), rv.end()) == "   aaNoSpec");
+
+	// the packed arguments behind format() against the tuple path
+	int ip = 0;
+	long double ld = 0.1L;
+	std::string longs(1000, 'b');
+
+	assert(stdex::vformat("{}|{:>5}|{:x}", stdex::make_format_args(true,
+	    'c', 255u)) == "true|    c|ff");
+	assert(format("{} {} {} {}", (signed char)-5, short(-6), -7L, -8LL) ==
+	    via_tuple("{} {} {} {}", (signed char)-5, short(-6), -7L, -8LL));
+	assert(format("{} {} {} {}", (unsigned char)5, (unsigned short)6, 7UL,
+	    std::numeric_limits<unsigned long long>::max()) ==
+	    via_tuple("{} {} {} {}", (unsigned char)5, (unsigned short)6, 7UL,
+	    std::numeric_limits<unsigned long long>::max()));
+	assert(format("{} {} {}", 0.1f, 0.1, ld) ==
+	    via_tuple("{} {} {}", 0.1f, 0.1, ld));
+	assert(format("{:p} {}", &ip, (void*)nullptr) ==
+	    via_tuple("{:p} {}", &ip, (void*)nullptr));
+	assert(format("{} {}", (signed char const*)"s", (unsigned char*)&ip) ==
+	    via_tuple("{} {}", (signed char const*)"s", (unsigned char*)&ip));
+	assert(format("{}|{:>4}", (char const*)"cc", (char*)&longs[0]) ==
+	    via_tuple("{}|{:>4}", (char const*)"cc", (char*)&longs[0]));
+
+	// a string of another character type is not taken for a pointer
+	using stdex::detail::arg_type;
+	using stdex::detail::arg_type_of;
+	static_assert(arg_type_of<wchar_t const*, char>::value ==
+	    arg_type::custom, "");
+	static_assert(arg_type_of<char*, wchar_t>::value ==
+	    arg_type::custom, "");
+	static_assert(arg_type_of<char16_t const volatile*, char32_t>::value ==
+	    arg_type::custom, "");
+	static_assert(arg_type_of<char32_t const*, char32_t>::value ==
+	    arg_type::string, "");
+	static_assert(arg_type_of<unsigned char const*, char>::value ==
+	    arg_type::pointer, "");
+
+	// nor is a pointer with a formatter<T*> of its own
+	Tagged tagged{ 7 };
+	std::string tagged_s;
+	stdex::format_to(std::back_inserter(tagged_s), "{}|{:>9}", &tagged,
+	    &tagged);
+	assert(tagged_s == "Tagged@7| Tagged@7");
+	assert(format("{}|{:>9}", &tagged, &tagged) == tagged_s);
+	static_assert(arg_type_of<Tagged*, char>::value ==
+	    arg_type::custom, "");
+	static_assert(arg_type_of<void const*, char>::value ==
+	    arg_type::pointer, "");
+
+	// a pointer to a function or to a volatile object is still written
+	// as an address
+	int volatile vip = 0;
+	assert(format("{}|{:p}", &noop, &vip) ==
+	    via_tuple("{}|{:p}", &noop, &vip));
+	static_assert(arg_type_of<void (*)(), char>::value ==
+	    arg_type::custom, "");
+	static_assert(arg_type_of<int volatile*, char>::value ==
+	    arg_type::custom, "");
+	assert(format("{:<10}|{:>10}|{}", stdex::string_view("sv"),
+	    std::string("str"), "lit") == "sv        |       str|lit");
+	assert(format("{}{:>1200}", longs, longs) ==
+	    longs + std::string(200, ' ') + longs);
+	assert(format("{:>*}|{}", 300, 'q', longs) ==
+	    std::string(299, ' ') + "q|" + longs);
+	assert(format(L"{:>4}|{}", 12, L"wide") == L"  12|wide");
+	assert(format(u"{:<3}|", u'x') == u"x  |");
+	assert(format(U"{}", U"u32") == U"u32");
+
+	assert_throw(std::out_of_range, format("{} {}", 1));
+	assert_throw(std::out_of_range, format("{2147483647}", 1));
+	assert_throw(std::overflow_error, format("{:*}", 4294967295UL, 1));
+	assert_throw(std::underflow_error, format("{:*}", -2147483649LL, 1));
+	assert_throw(std::invalid_argument, format("{:*}", 8.0, 1));
+	assert_throw(std::invalid_argument, format("{:*}", NoSpec(), 1));
+	assert_throw(std::invalid_argument, format("{:s}", NoSpec()));
+	assert_throw(std::invalid_argument, format("{:d}", "str"));
 }
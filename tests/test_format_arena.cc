@@ -0,0 +1,198 @@
+#include "../format_arena.h"
+
+#include "assertions.h"
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<memory_resource>) && __cplusplus >= 201703L
+#include <memory_resource>
+#define HAS_PMR
+#endif
+#endif
+
+using stdex::format_arena;
+using stdex::format_into_arena;
+using namespace stdex::string_literals;
+
+void test_initial_buffer()
+{
+	char buf[64];
+	format_arena a(buf, sizeof(buf), 128);
+
+	auto s1 = format_into_arena(a, "{}:{}", "host", 8080);
+	auto s2 = format_into_arena(a, "{:>6}", 42);
+
+	assert(s1 == "host:8080");
+	assert(s2 == "    42");
+	assert(s1.data() == buf);
+	assert(s2.data() == buf + s1.size());
+	assert(a.capacity() == sizeof(buf));
+
+	// outgrows buf; the finished strings stay put
+	auto s3 = format_into_arena(a, "{}", std::string(100, 'x'));
+
+	assert(s3 == std::string(100, 'x'));
+	assert(s1 == "host:8080");
+	assert(a.capacity() > sizeof(buf));
+
+	a.reset();
+
+	auto capacity = a.capacity();
+	auto s4 = format_into_arena(a, "{}", 1);
+
+	assert(s4 == "1");
+	assert(s4.data() == buf);
+
+	format_into_arena(a, "{}", std::string(100, 'x'));
+	assert(a.capacity() == capacity);
+
+	a.release();
+	assert(a.capacity() == sizeof(buf));
+}
+
+void test_growth()
+{
+	format_arena a(32);
+	std::vector<stdex::string_view> v;
+
+	for (int i = 0; i < 200; ++i)
+		v.push_back(format_into_arena(a, "{}{}", std::string(i, '-'),
+		    i));
+
+	for (int i = 0; i < 200; ++i)
+		assert(v[i] == std::string(i, '-') + std::to_string(i));
+
+	auto capacity = a.capacity();
+
+	a.reset();
+
+	for (int i = 0; i < 200; ++i)
+		v[i] = format_into_arena(a, "{}{}", std::string(i, '-'), i);
+
+	for (int i = 0; i < 200; ++i)
+		assert(v[i] == std::string(i, '-') + std::to_string(i));
+
+	assert(a.capacity() == capacity);
+}
+
+void test_character_types()
+{
+	format_arena a(256);
+
+	auto s1 = format_into_arena(a, "{}", 'x');
+	auto s2 = format_into_arena(a, U"{:<4}|", 7);
+	auto s3 = format_into_arena(a, u"{}", 3.5);
+	auto s4 = format_into_arena(a, L"{}", L"wide");
+
+	assert(s1 == "x");
+	assert(s2 == U"7   |");
+	assert(s3 == u"3.5");
+	assert(s4 == L"wide");
+	assert(reinterpret_cast<std::uintptr_t>(s2.data()) %
+	    alignof(char32_t) == 0);
+}
+
+void test_failure()
+{
+	char buf[64];
+	format_arena a(buf, sizeof(buf));
+
+	auto s1 = format_into_arena(a, "{}", 1);
+
+	assert_throw(std::invalid_argument,
+	    format_into_arena(a, "{}{", 2));
+
+	auto s2 = format_into_arena(a, "{}", 3);
+
+	assert(s1 == "1");
+	assert(s2 == "3");
+	assert(s2.data() == s1.data() + 1);
+}
+
+void test_sink()
+{
+	format_arena a;
+	stdex::arena_sink buf(a);
+	int x = 1, y = 2;
+
+	stdex::detail::vsformat(buf, "{}, "_sv, std::forward_as_tuple(x));
+	stdex::detail::vsformat(buf, "{}"_sv, std::forward_as_tuple(y));
+
+	auto s = buf.release();
+
+	assert(s == "1, 2");
+}
+
+// a memory resource in the shape of std::pmr::memory_resource
+struct counted_resource
+{
+	void* allocate(std::size_t n, std::size_t)
+	{
+		++blocks;
+		return ::operator new(n);
+	}
+
+	void deallocate(void* p, std::size_t, std::size_t)
+	{
+		--blocks;
+		::operator delete(p);
+	}
+
+	int blocks = 0;
+};
+
+void test_resource()
+{
+	counted_resource r;
+
+	{
+		format_arena a(&r, 16);
+
+		for (int i = 0; i < 10; ++i)
+			assert(format_into_arena(a, "{:>20}", i) ==
+			    std::string(19, ' ') + std::to_string(i));
+
+		assert(r.blocks > 0);
+	}
+
+	assert(r.blocks == 0);
+}
+
+#if defined(HAS_PMR)
+
+void test_pmr()
+{
+	char buf[256];
+	std::pmr::monotonic_buffer_resource mr(buf, sizeof(buf));
+	format_arena a(&mr, 64);
+
+	auto s1 = format_into_arena(a, "{}", "on the resource");
+
+	assert(s1 == "on the resource");
+	assert(buf <= s1.data() and s1.data() < buf + sizeof(buf));
+
+	auto s2 = stdex::format(std::pmr::polymorphic_allocator<char>(&mr),
+	    "{}-{}", 1, 2);
+
+	static_assert(std::is_same<decltype(s2), std::pmr::string>(), "");
+	assert(s2 == "1-2");
+	assert(s2.get_allocator().resource() == &mr);
+
+	a.release();
+	mr.release();
+}
+
+#endif
+
+int main()
+{
+	test_initial_buffer();
+	test_growth();
+	test_character_types();
+	test_failure();
+	test_sink();
+	test_resource();
+#if defined(HAS_PMR)
+	test_pmr();
+#endif
+}
@@ -0,0 +1,90 @@
+#include "../format_cache.h"
+
+#include "assertions.h"
+
+#include <thread>
+#include <vector>
+
+using stdex::format;
+using stdex::cached_format;
+using stdex::format_cache;
+
+int main()
+{
+	std::string fmt = "{}: {:>6} [{:.2f}] {{x}}";
+
+	assert(cached_format(fmt, 42, "abc", 3.14159) ==
+	    format(fmt, 42, "abc", 3.14159));
+	assert(cached_format(L"{2}{1}", 7, 3) == L"37");
+	assert(cached_format(u"a{{b}}c{}", 1) == u"a{b}c1");
+	assert(cached_format(U"") == U"");
+
+	format_cache c(3);
+
+	assert(cached_format(c, "{:<4}|", 1) == "1   |");
+	assert(c.hits() == 0 and c.misses() == 1 and c.size() == 1);
+	assert(cached_format(c, "{:<4}|", 2) == "2   |");
+	assert(c.hits() == 1 and c.misses() == 1);
+
+	// a copy with equal contents finds the same entry
+	std::string s = "{:<4}|";
+	assert(cached_format(c, s, 3) == "3   |");
+	assert(c.hits() == 2 and c.misses() == 1);
+
+	assert(cached_format(c, "{:x}", 255) == "ff");
+	assert(cached_format(c, "{:b}", 5) == "101");
+	assert(cached_format(c, "{:<4}|", 4) == "4   |");
+	assert(cached_format(c, "{:o}", 8) == "10");
+	assert(c.size() == 3 and c.misses() == 4);
+
+	// "{:x}" was the least recently used; this thread still holds it
+	assert(cached_format(c, "{:x}", 15) == "f");
+	assert(c.misses() == 4);
+	std::thread([&]
+	    {
+		assert(cached_format(c, "{:o}", 15) == "17");
+		assert(c.misses() == 4);
+		assert(cached_format(c, "{:x}", 15) == "f");
+		assert(c.misses() == 5);
+	    }).join();
+
+	auto p = c.get("{:<4}|");
+	assert(p->str() == "{:<4}|");
+	c.set_capacity(1);
+	assert(c.size() == 1 and c.capacity() == 1);
+	assert(p->str() == "{:<4}|");
+
+	assert_throw(std::invalid_argument, cached_format(c, "{", 1));
+	assert_throw(std::out_of_range, cached_format(c, "{3}", 1));
+	assert_throw(std::invalid_argument, cached_format(c, "{:q}", 1));
+
+	{
+		format_cache d;
+		assert(cached_format(d, "{:x}", 16) == "10");
+		assert(d.misses() == 1);
+	}
+
+	format_cache e;
+	assert(cached_format(e, "{:x}", 17) == "11");
+	assert(e.misses() == 1 and e.hits() == 0);
+
+	format_cache shared(8);
+	std::vector<std::thread> threads;
+
+	for (int t = 0; t < 4; ++t)
+		threads.emplace_back([&, t]
+		    {
+			for (int i = 0; i < 2000; ++i)
+			{
+				auto f = format("<{{}}{}:{}>", t, i % 12);
+				assert(cached_format(shared, f, i) ==
+				    format(f, i));
+			}
+		    });
+
+	for (auto& th : threads)
+		th.join();
+
+	assert(shared.hits() + shared.misses() == 8000);
+	assert(shared.size() <= 8);
+}
@@ -2,6 +2,8 @@
 #include "../__formatter.h"
 
 #include <cassert>
+#include <deque>
+#include <vector>
 
 using namespace stdex::string_literals;
 
@@ -68,4 +70,45 @@ int main()
 		w2.justify_content();
 		assert(ts == "1.  te\0st"_sv);
 	}
+
+	ts.erase();
+
+	{
+		stdex::format_writer<std::string> w(ts, 5, true);
+		w.content_width_will_be(3);
+
+		auto p = w.extend(3);
+		p[0] = '4';
+		p[1] = '2';
+		p[2] = '!';
+		w.justify_content();
+		assert(ts == "  42!");
+	}
+
+	std::vector<char> tv = { 'a' };
+
+	{
+		stdex::format_writer<std::vector<char>> w(tv, 5, true);
+		w.send("bc");
+		auto p = w.extend(1);
+		*p = 'd';
+		w.justify_content();
+		assert(std::string(tv.begin(), tv.end()) == "a  bcd");
+	}
+
+	// a deque has no extend() and is not contiguous; the rest works
+	std::deque<char> td(500, '.');
+
+	{
+		stdex::format_writer<std::deque<char>> w(td, 6, true);
+		w.send("ab");
+		w.send(2, 'c');
+		w.justify_content();
+		assert(std::string(td.begin() + 500, td.end()) == "  abcc");
+	}
+
+	static_assert(not stdex::is_contiguous_sink<std::deque<char>>::value,
+	    "");
+	static_assert(stdex::is_contiguous_sink<std::vector<char>>::value, "");
+	static_assert(stdex::is_contiguous_sink<std::string>::value, "");
 }
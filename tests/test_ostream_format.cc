@@ -4,6 +4,84 @@
 
 #include <sstream>
 #include <iostream>
+#include <stdexcept>
+
+// a put area of a fixed size; what does not fit there goes through
+// xsputn(), and is recorded in slow
+struct fixed_buf : std::streambuf
+{
+	explicit fixed_buf(std::size_t n) : area(n, '\0')
+	{
+		setp(&area[0], &area[0] + n);
+	}
+
+	std::string put() const
+	{
+		return std::string(pbase(), pptr());
+	}
+
+	std::streamsize xsputn(char const* s, std::streamsize n) override
+	{
+		slow.append(s, n);
+		return n;
+	}
+
+	int_type overflow(int_type ch) override
+	{
+		slow.push_back(traits_type::to_char_type(ch));
+		return ch;
+	}
+
+	std::string area;
+	std::string slow;
+};
+
+// sends a part of its output before failing
+struct faulty {};
+
+template <>
+struct stdex::formatter<faulty>
+{
+	template <typename Writer>
+	void output(Writer w, faulty)
+	{
+		w.send(stdex::string_view("partial"));
+		throw std::runtime_error("faulty");
+	}
+};
+
+void test_put_area()
+{
+	fixed_buf sb(16);
+	std::ostream os(&sb);
+	auto trace = stdex::make_formatted(os);
+
+	assert(trace("{}-{:>4}", 1, "two"));
+	assert(sb.put() == "1- two");
+	assert(sb.slow.empty());
+
+	assert(not trace("{}{}", "x", faulty()));
+	assert(os.rdstate() == std::ios_base::failbit);
+	assert(sb.put() == "1- two");
+	assert(sb.slow.empty());
+
+	os.clear();
+
+	// spills over when the output outgrows the put area
+	assert(trace("|{}|", std::string(12, 'x')));
+	assert(sb.put() == "1- two");
+	assert(sb.slow == "|xxxxxxxxxxxx|");
+
+	sb.slow.clear();
+
+	// and is not tried when the put area is shorter than fmt
+	assert(trace("{}{}{}{}{}{}", 1, 2, 3, 4, 5, 6));
+	assert(sb.put() == "1- two");
+	assert(sb.slow == "123456");
+
+	assert(trace("{}", 7));
+	assert(sb.put() == "1- two7");
+}
 
 
 int main()
@@ -37,4 +115,6 @@ int main()
 	auto wprintf = stdex::make_formatted(std::wcout);
 
 	wprintf(L"hello, {}\n", L"world");
+
+	test_put_area();
 }
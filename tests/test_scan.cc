@@ -0,0 +1,119 @@
+#include "../__scan.h"
+
+#include <cassert>
+#include <random>
+#include <string>
+#include <algorithm>
+
+template <typename CharT>
+void fill(std::basic_string<CharT>& s, std::mt19937& gen)
+{
+	// neighbours of the needles, and lanes with a high bit
+	for (auto& c : s)
+	{
+		switch (gen() % 8)
+		{
+		case 0: c = CharT('z'); break;
+		case 1: c = CharT('|'); break;
+		case 2: c = CharT('{' + 256); break;
+		case 3: c = CharT(0x80 | '{'); break;
+		case 4: c = CharT(0); break;
+		}
+	}
+
+	auto len = s.size();
+
+	if (len != 0 and gen() % 4 != 0)
+		s[gen() % len] = gen() % 2 ? CharT('{') : CharT('}');
+
+	if (len != 0 and gen() % 2 != 0)
+		s[gen() % len] = CharT('}');
+}
+
+template <bool Match, typename CharT>
+std::size_t naive_of(CharT const* p, std::size_t n, CharT const* set,
+    std::size_t k)
+{
+	return std::find_if(p, p + n, [=](CharT c)
+	    {
+		return (std::find(set, set + k, c) != set + k) == Match;
+	    }) - p;
+}
+
+template <typename CharT>
+std::size_t naive_search(CharT const* p, std::size_t n, CharT const* s,
+    std::size_t m)
+{
+	return std::search(p, p + n, s, s + m) - p;
+}
+
+template <typename CharT>
+void check(std::mt19937& gen)
+{
+	using namespace stdex::detail;
+
+	CharT const set[] = { CharT('{'), CharT('}'), CharT(0),
+	    CharT('{' + 256), CharT('a'), CharT(0x80 | '{'), CharT('z') };
+	std::basic_string<CharT> s;
+
+	for (int len = 0; len < 100; ++len)
+	{
+		for (int trial = 0; trial < 20; ++trial)
+		{
+			s.assign(len, CharT('a'));
+			fill(s, gen);
+
+			for (int off = 0; off <= len; ++off)
+			{
+				auto p = s.data() + off;
+				std::size_t n = len - off;
+				auto want = scan_scalar<true, 2>(p, 0, n, set);
+
+				assert(find_brace(p, n) == want);
+				assert((scan<true, 2>(p, 0, n, set) == want));
+				assert((scan_swar<true, 2>(p, 0, n, set) == want));
+
+				want = scan_scalar<false, 3>(p, 0, n, set + 2);
+
+				assert((scan<false, 3>(p, 0, n, set + 2) == want));
+				assert((scan_swar<false, 3>(p, 0, n, set + 2) ==
+				    want));
+
+				for (std::size_t k = 0; k <= 7; ++k)
+				{
+					assert((find_of<true>(p, 0, n, set, k) ==
+					    naive_of<true>(p, n, set, k)));
+					assert((find_of<false>(p, 0, n, set, k) ==
+					    naive_of<false>(p, n, set, k)));
+				}
+			}
+
+			for (int m = 2; m < 6 and m <= len; ++m)
+			{
+				auto needle = s.substr(gen() % (len - m + 1), m);
+
+				if (gen() % 2)
+					needle[gen() % m] = CharT('{');
+
+				for (int off = 0; off + m <= len; ++off)
+				{
+					auto p = s.data() + off;
+					std::size_t n = len - off;
+
+					assert(search(p, 0, n, needle.data(), m) ==
+					    naive_search(p, n, needle.data(), m));
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	std::mt19937 gen;
+
+	check<char>(gen);
+	check<wchar_t>(gen);
+	check<char16_t>(gen);
+	check<char32_t>(gen);
+}
@@ -3,6 +3,8 @@
 #include "assertions.h"
 #include <sstream>
 #include <iomanip>
+#include <unordered_map>
+#include <unordered_set>
 
 using stdex::string_view;
 using namespace stdex::string_literals;
@@ -110,6 +112,69 @@ int main()
 	assert(sv1.find_first_not_of("", 2, 0) == 2);
 	assert(sv1.find_first_not_of(""_sv, sv1.length()) == string_view::npos);
 
+	// long enough for the vector kernels
+	auto text = std::string(70, '-') + "Host: a\r\n\r\n";
+	string_view line = text;
+
+	assert(line.find('H') == 70);
+	assert(line.find("\r\n\r\n") == 77);
+	assert(line.find("\r\n\r\n", 78) == string_view::npos);
+	assert(line.find("--H") == 68);
+	assert(line.find("-H-") == string_view::npos);
+	assert(line.find_first_of(":\r") == 74);
+	assert(line.find_first_of("\r\n\t :;,") == 74);
+	assert(line.find_first_of("\r\n\t;,", 76) == 77);
+	assert(line.find_first_not_of('-') == 70);
+	assert(line.find_first_not_of("-Hos") == 73);
+	assert(line.find_first_not_of("-Host: a\r\n") == string_view::npos);
+
+	stdex::u16string_view u16 = u"\u4e2d\u6587\u4e2d\u6587\u4e2d\u6587\u4e2d"
+	    u"\u6587\u4e2d\u6587 \u0102\u00ff";
+
+	assert(u16.find(u'\u0102') == 11);
+	assert(u16.find(u"\u6587 ") == 9);
+	assert(u16.find_first_of(u"\u00ff\u0102") == 11);
+	assert(u16.find_first_of(u"\u00ff\u0102 abcd") == 10);
+	assert(u16.find_first_not_of(u"\u6587\u4e2d \u00ff") == 11);
+
+	constexpr auto host = stdex::static_hash("Host"_sv);
+
+	static_assert(host != stdex::static_hash("host"_sv), "");
+	static_assert(stdex::static_hash(u"Host"_sv) !=
+	    stdex::static_hash(U"Host"_sv), "");
+
+	std::hash<string_view> hash;
+	std::hash<stdex::u32string_view> hash32;
+	std::unordered_set<std::size_t> seen;
+	std::string key;
+	std::u32string key32;
+
+	for (int i = 0; i < 300; ++i)
+	{
+		assert(stdex::static_hash(string_view(key)) == hash(key));
+		assert(stdex::static_hash(stdex::u32string_view(key32)) ==
+		    hash32(key32));
+		assert(seen.insert(hash(key)).second);
+
+		key += char(0x80 + i * 37);
+		key32 += char32_t(0x10000 + i * 7919);
+	}
+
+	switch (hash("Host"))
+	{
+	case host:
+		break;
+	default:
+		assert(false);
+	}
+
+	std::unordered_map<string_view, int> headers = {
+		{ "Host", 1 }, { "Accept", 2 }, { "Content-Length", 3 },
+	};
+
+	assert(headers.at("Accept") == 2);
+	assert(headers.count(text) == 0);
+
 	std::stringstream ss;
 	ss << sv1;
 	assert(ss.str() == sv1);
@@ -0,0 +1,52 @@
+// Prints the text of the events in binary logs written by
+// stdex::binary_log_writer, in order; reads the standard input when
+// no file is named.
+
+#include "../binary_log.h"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+static bool decode(std::istream& in, std::ostream& out)
+{
+	stdex::binary_log_reader rd(in);
+	std::string s;
+
+	while (rd.next(s))
+		out.write(s.data(), std::streamsize(s.size()));
+
+	return bool(out);
+}
+
+int main(int argc, char* argv[])
+{
+	std::ios::sync_with_stdio(false);
+
+	try
+	{
+		if (argc == 1)
+			return decode(std::cin, std::cout) ? 0 : 1;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			std::ifstream in(argv[i], std::ios::binary);
+
+			if (not in)
+			{
+				std::cerr << argv[0] << ": cannot open " <<
+				    argv[i] << '\n';
+				return 1;
+			}
+
+			if (not decode(in, std::cout))
+				return 1;
+		}
+	}
+	catch (std::exception& e)
+	{
+		std::cout.flush();
+		std::cerr << argv[0] << ": " << e.what() << '\n';
+		return 1;
+	}
+}
@@ -139,6 +139,16 @@ struct flipped
 template <bool V>
 using bool_constant = std::integral_constant<bool, V>;
 
+// through a class template, for CWG 1558
+template <typename... T>
+struct make_void
+{
+	using type = void;
+};
+
+template <typename... T>
+using void_t = typename make_void<T...>::type;
+
 template <typename X>
 struct Not : bool_constant
 	<